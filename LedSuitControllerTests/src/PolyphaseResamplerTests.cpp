@@ -0,0 +1,89 @@
+#include "TestSupport.h"
+#include "include/core/PolyphaseResampler.h"
+#include "include/core/SimdKernels.h"
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+// A resampler restarted at a checkpoint (a multiple of downsampling(), with the historyLength()
+// input samples before it, as SeekIndex stores them) must produce exactly the samples a full run
+// produces from there on; the streaming reader relies on it to decode from the middle of a track.
+
+namespace {
+
+struct RatePair {
+    int input;
+    int output;
+};
+
+const RatePair kRates[] = { { 44100, 48000 }, { 48000, 44100 }, { 22050, 48000 }, { 96000, 48000 }, { 48000, 48000 } };
+constexpr size_t kInputSamples = 100003; // Not a multiple of any block or factor
+constexpr size_t kBlockSamples = 4093;   // Odd blocks, like a decoder's partial reads
+
+// Feeds input[first, end) in blocks, then flushes
+std::vector<float> run(PolyphaseResampler& resampler, const std::vector<float>& input, size_t first) {
+    std::vector<float> output;
+    for (size_t begin = first; begin < input.size(); begin += kBlockSamples) {
+        resampler.process(input.data() + begin, std::min(kBlockSamples, input.size() - begin), output);
+    }
+    resampler.flush(output);
+    return output;
+}
+
+} // namespace
+
+int runPolyphaseResamplerTests() {
+    TestContext context("PolyphaseResampler restart");
+    std::mt19937 rng(11);
+    std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+    std::vector<float> input(kInputSamples);
+    for (float& value : input) {
+        value = distribution(rng);
+    }
+
+    for (simd::InstructionSet set : { simd::InstructionSet::Scalar, simd::InstructionSet::SSE41, simd::InstructionSet::AVX2 }) {
+        simd::limitInstructionSet(set);
+        if (simd::activeInstructionSet() != set) {
+            continue; // Not on this CPU
+        }
+        for (const RatePair& rates : kRates) {
+            const std::string name = std::to_string(rates.input) + " -> " + std::to_string(rates.output) +
+                                     " [" + simd::instructionSetName(set) + "]";
+            PolyphaseResampler full(rates.input, rates.output);
+            const std::vector<float> reference = run(full, input, 0);
+            context.check(name + " full output length", reference.size() == full.outputLength(kInputSamples));
+
+            // Checkpoints at the start, inside the first history length, and spread over the input
+            const uint64_t step = static_cast<uint64_t>(full.downsampling());
+            const size_t history = static_cast<size_t>(full.historyLength());
+            for (uint64_t checkpoint : { uint64_t(0), step, 7 * step, kInputSamples / 3 / step * step,
+                                         (kInputSamples - 1) / step * step }) {
+                // History as SeekIndex keeps it: silence before the first input sample
+                std::vector<float> previous(history, 0.0f);
+                for (size_t j = 0; j < history; ++j) {
+                    int64_t source = static_cast<int64_t>(checkpoint) - static_cast<int64_t>(history - j);
+                    if (source >= 0) {
+                        previous[j] = input[static_cast<size_t>(source)];
+                    }
+                }
+
+                PolyphaseResampler restarted(rates.input, rates.output);
+                restarted.restart(checkpoint, previous.data());
+                const std::vector<float> output = run(restarted, input, static_cast<size_t>(checkpoint));
+
+                const std::string at = name + " restart at " + std::to_string(checkpoint);
+                const size_t firstOutput = static_cast<size_t>(full.outputLength(checkpoint));
+                if (!context.check(at + " output length", firstOutput + output.size() == reference.size())) {
+                    continue;
+                }
+                for (size_t i = 0; i < output.size(); ++i) {
+                    context.near(at + " sample " + std::to_string(firstOutput + i), output[i], reference[firstOutput + i], 0.0);
+                }
+            }
+        }
+    }
+    simd::limitInstructionSet(simd::InstructionSet::AVX2);
+
+    return context.finish();
+}
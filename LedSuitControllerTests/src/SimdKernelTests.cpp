@@ -0,0 +1,196 @@
+#include "TestSupport.h"
+#include "include/core/SimdKernels.h"
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+// Every vector path against the scalar reference, on the lengths around the vector widths (the
+// tails) and on pointers that are not 16/32-byte aligned. Guard values behind each output catch
+// tails that write past count.
+
+namespace {
+
+const size_t kLengths[] = { 0, 1, 3, 4, 5, 7, 8, 9, 15, 16, 17, 31, 32, 33, 1000 };
+const size_t kOffsets[] = { 0, 1, 3 }; // In floats: aligned, then off by 4 and 12 bytes
+constexpr size_t kGuard = 16;
+constexpr float kSentinel = -12345.0f;
+
+// Elementwise kernels are exact or one rounding away; the polynomial log is the loosest
+constexpr double kExact = 0.0;
+constexpr double kRelative = 1e-6;
+constexpr double kLogAbsolute = 3e-5;
+
+struct Buffer {
+    std::vector<float> storage;
+    size_t offset;
+    size_t count;
+
+    Buffer(size_t count, size_t offset) : storage(offset + count + kGuard, kSentinel), offset(offset), count(count) {}
+    float* data() { return storage.data() + offset; }
+    bool guardIntact() const {
+        return std::all_of(storage.begin() + offset + count, storage.end(), [](float v) { return v == kSentinel; });
+    }
+};
+
+std::vector<float> randomValues(size_t count, float low, float high, std::mt19937& rng) {
+    std::uniform_real_distribution<float> distribution(low, high);
+    std::vector<float> values(count);
+    for (float& value : values) {
+        value = distribution(rng);
+    }
+    return values;
+}
+
+// Runs kernel(set) once per vector instruction set the CPU supports and compares its outputs with
+// the scalar run. kernel fills its output buffers from scratch on every call.
+void compareSets(TestContext& context, const std::string& name,
+                 const std::function<std::vector<float>()>& kernel,
+                 const std::function<double(double reference)>& tolerance) {
+    simd::limitInstructionSet(simd::InstructionSet::Scalar);
+    const std::vector<float> reference = kernel();
+
+    for (simd::InstructionSet set : { simd::InstructionSet::SSE41, simd::InstructionSet::AVX2 }) {
+        simd::limitInstructionSet(set);
+        if (simd::activeInstructionSet() != set) {
+            continue; // Not on this CPU
+        }
+        const std::vector<float> result = kernel();
+        if (!context.check(name + " [" + simd::instructionSetName(set) + "] output size", result.size() == reference.size())) {
+            continue;
+        }
+        for (size_t i = 0; i < result.size(); ++i) {
+            context.near(name + " [" + simd::instructionSetName(set) + "] element " + std::to_string(i),
+                         result[i], reference[i], tolerance(reference[i]));
+        }
+    }
+    simd::limitInstructionSet(simd::InstructionSet::AVX2);
+}
+
+double exact(double) { return kExact; }
+double relative(double reference) { return kRelative * std::max(1.0, std::fabs(reference)); }
+double logAbsolute(double) { return kLogAbsolute; }
+
+// Output values followed by a 0/1 flag per buffer telling whether its guard survived
+void appendGuard(std::vector<float>& out, const Buffer& buffer) {
+    out.push_back(buffer.guardIntact() ? 1.0f : 0.0f);
+}
+
+} // namespace
+
+int runSimdKernelTests() {
+    TestContext context("SimdKernels");
+    std::mt19937 rng(42);
+
+    std::cout << "SimdKernels: CPU supports up to " << simd::instructionSetName(simd::activeInstructionSet()) << std::endl;
+
+    for (size_t count : kLengths) {
+        for (size_t offset : kOffsets) {
+            const std::string shape = " n=" + std::to_string(count) + " offset=" + std::to_string(offset);
+            const std::vector<float> a = randomValues(count, -1.0f, 1.0f, rng);
+            const std::vector<float> b = randomValues(count, -1.0f, 1.0f, rng);
+            const std::vector<float> interleaved = randomValues(2 * count, -4.0f, 4.0f, rng);
+            std::vector<float> magnitudes = randomValues(count, 0.0f, 100.0f, rng);
+            std::vector<float> levels = randomValues(count, 0.0f, 10.0f, rng);
+            // Edge values of the log kernels: zero, the floor, a subnormal and a large value
+            const float edges[] = { 0.0f, 0.01f, 1e-40f, 1e6f };
+            for (size_t i = 0; i < count && i < 4; ++i) {
+                magnitudes[i] = edges[i];
+                levels[i] = edges[i];
+            }
+
+            compareSets(context, "multiply" + shape, [&]() {
+                Buffer inA(count, offset), inB(count, offset), out(count, offset);
+                std::copy(a.begin(), a.end(), inA.data());
+                std::copy(b.begin(), b.end(), inB.data());
+                simd::multiply(inA.data(), inB.data(), out.data(), count);
+                std::vector<float> result(out.data(), out.data() + count);
+                appendGuard(result, out);
+                return result;
+            }, exact);
+
+            compareSets(context, "mixAdd" + shape, [&]() {
+                Buffer in(count, offset), out(count, offset);
+                std::copy(a.begin(), a.end(), in.data());
+                std::copy(b.begin(), b.end(), out.data());
+                simd::mixAdd(in.data(), out.data(), count, 0.7f);
+                std::vector<float> result(out.data(), out.data() + count);
+                appendGuard(result, out);
+                return result;
+            }, relative);
+
+            compareSets(context, "complexMagnitude" + shape, [&]() {
+                Buffer in(2 * count, offset), out(count, offset);
+                std::copy(interleaved.begin(), interleaved.end(), in.data());
+                simd::complexMagnitude(in.data(), out.data(), count);
+                std::vector<float> result(out.data(), out.data() + count);
+                appendGuard(result, out);
+                return result;
+            }, relative);
+
+            compareSets(context, "sum/dot/max" + shape, [&]() {
+                Buffer inA(count, offset), inB(count, offset);
+                std::copy(a.begin(), a.end(), inA.data());
+                std::copy(b.begin(), b.end(), inB.data());
+                return std::vector<float>{ simd::sum(inA.data(), count), simd::dot(inA.data(), inB.data(), count),
+                                           count > 0 ? simd::max(inA.data(), count) : 0.0f };
+            }, [count](double reference) {
+                // Vector paths add in a different order; the error grows with the length
+                return kRelative * std::max<double>(1.0, static_cast<double>(count)) * std::max(1.0, std::fabs(reference));
+            });
+
+            compareSets(context, "log10OnePlus" + shape, [&]() {
+                Buffer data(count, offset);
+                std::copy(magnitudes.begin(), magnitudes.end(), data.data());
+                simd::log10OnePlus(data.data(), count, 0.5f);
+                std::vector<float> result(data.data(), data.data() + count);
+                appendGuard(result, data);
+                return result;
+            }, logAbsolute);
+
+            compareSets(context, "log10Remap" + shape, [&]() {
+                Buffer data(count, offset);
+                std::copy(levels.begin(), levels.end(), data.data());
+                simd::log10Remap(data.data(), count, 0.01f, -2.0f, 1.0f / 3.0f);
+                std::vector<float> result(data.data(), data.data() + count);
+                appendGuard(result, data);
+                return result;
+            }, logAbsolute);
+
+            for (int channels : { 1, 2, 3, 6 }) {
+                const std::vector<float> frames = randomValues(count * channels, -1.0f, 1.0f, rng);
+                compareSets(context, "downmix channels=" + std::to_string(channels) + shape, [&]() {
+                    Buffer in(count * channels, offset), out(count, offset);
+                    std::copy(frames.begin(), frames.end(), in.data());
+                    simd::downmix(in.data(), out.data(), count, channels);
+                    std::vector<float> result(out.data(), out.data() + count);
+                    appendGuard(result, out);
+                    return result;
+                }, relative);
+            }
+
+            for (size_t blockSize : { size_t(1), size_t(4), size_t(7), size_t(64) }) {
+                const size_t blocks = (count + blockSize - 1) / blockSize;
+                compareSets(context, "blockStats block=" + std::to_string(blockSize) + shape, [&]() {
+                    Buffer in(count, offset), mins(blocks, offset), maxs(blocks, offset), energies(blocks, offset);
+                    std::copy(a.begin(), a.end(), in.data());
+                    simd::blockStats(in.data(), count, blockSize, mins.data(), maxs.data(), energies.data());
+                    std::vector<float> result;
+                    result.insert(result.end(), mins.data(), mins.data() + blocks);
+                    result.insert(result.end(), maxs.data(), maxs.data() + blocks);
+                    result.insert(result.end(), energies.data(), energies.data() + blocks);
+                    appendGuard(result, mins);
+                    appendGuard(result, maxs);
+                    appendGuard(result, energies);
+                    return result;
+                }, [blockSize](double reference) {
+                    return kRelative * static_cast<double>(blockSize) * std::max(1.0, std::fabs(reference));
+                });
+            }
+        }
+    }
+
+    return context.finish();
+}
@@ -0,0 +1,66 @@
+#ifndef TEST_SUPPORT_H
+#define TEST_SUPPORT_H
+
+#include <cmath>
+#include <cstddef>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <utility>
+
+// Minimal check helpers for the console test runner: every failed check is printed and counted,
+// main() turns the count into the exit code.
+class TestContext {
+public:
+    explicit TestContext(std::string suiteName) : suite(std::move(suiteName)) {}
+
+    // |actual - expected| <= tolerance; NaN never passes
+    bool near(const std::string& what, double actual, double expected, double tolerance) {
+        ++checks;
+        double error = std::fabs(actual - expected);
+        if (!(error <= tolerance)) {
+            std::ostringstream message;
+            message << std::setprecision(9) << what << ": got " << actual << ", expected " << expected
+                    << " (error " << error << ", tolerance " << tolerance << ")";
+            fail(message.str());
+            return false;
+        }
+        return true;
+    }
+
+    bool check(const std::string& what, bool condition) {
+        ++checks;
+        if (!condition) {
+            fail(what);
+        }
+        return condition;
+    }
+
+    void fail(const std::string& message) {
+        ++failures;
+        if (failures <= kMaxReported) {
+            std::cout << "  FAIL [" << suite << "] " << message << std::endl;
+        }
+    }
+
+    // Prints the summary line; returns the number of failed checks
+    int finish() const {
+        std::cout << suite << ": " << checks - failures << "/" << checks << " checks passed" << std::endl;
+        return failures;
+    }
+
+private:
+    static constexpr int kMaxReported = 20; // A broken kernel fails thousands of checks
+
+    std::string suite;
+    int checks = 0;
+    int failures = 0;
+};
+
+// Suites, one translation unit each; return the number of failed checks
+int runSimdKernelTests();
+int runPolyphaseResamplerTests();
+int runResamplerBenchmark(); // Also prints the conversion throughput
+
+#endif // TEST_SUPPORT_H
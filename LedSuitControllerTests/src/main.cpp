@@ -0,0 +1,13 @@
+#include "TestSupport.h"
+#include <iostream>
+
+// Console runner for the core tests; exit code 0 when every check passed
+int main() {
+    int failures = 0;
+    failures += runSimdKernelTests();
+    failures += runPolyphaseResamplerTests();
+    failures += runResamplerBenchmark();
+
+    std::cout << (failures == 0 ? "All tests passed." : "Tests FAILED.") << std::endl;
+    return failures == 0 ? 0 : 1;
+}
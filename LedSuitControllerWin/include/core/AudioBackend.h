@@ -0,0 +1,39 @@
+#ifndef AUDIO_BACKEND_H
+#define AUDIO_BACKEND_H
+
+#include <functional>
+#include <memory>
+
+// Output device behind AudioPlayer. A backend pulls mono float buffers from the player on its own
+// thread and stamps each with the time its first sample is heard (dacTime, in the now() time base).
+// Real devices use the steady clock; the null and offline backends run a virtual clock, so playback,
+// cursor and trigger timing also run headless, faster than real time and deterministically.
+class AudioBackend {
+public:
+    // Returns false if the player cannot fill the buffer yet. Only backends that are not real time
+    // honor it: they ask again instead of advancing their clock, so a slow feeder never shows up
+    // as silence in the output.
+    using RenderCallback = std::function<bool(float* out, unsigned long frames, double dacTime)>;
+
+    virtual ~AudioBackend() = default;
+
+    virtual const char* name() const = 0;
+    virtual int preferredSampleRate() const = 0;
+    virtual bool isRealTime() const = 0;
+
+    // Starts pulling buffers until close(); false if the device cannot be opened
+    virtual bool open(int sampleRate, unsigned long framesPerBuffer, RenderCallback render) = 0;
+    virtual void close() = 0;
+    virtual bool isOpen() const = 0;
+
+    virtual double outputLatency() const = 0; // Seconds from render to DAC
+    virtual double now() const = 0;           // Current time in the dacTime base
+
+    // Picks the backend from LEDSUIT_AUDIO_BACKEND:
+    //   unset or "portaudio"        the default output device
+    //   "null[:speed]"              no device, virtual clock at speed x real time (default: as fast as possible)
+    //   "offline:<file.wav>[:speed]" like null, and the output is written to a WAV file on close
+    static std::unique_ptr<AudioBackend> fromEnvironment();
+};
+
+#endif // AUDIO_BACKEND_H
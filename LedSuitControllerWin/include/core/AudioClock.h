@@ -0,0 +1,64 @@
+#ifndef AUDIO_CLOCK_H
+#define AUDIO_CLOCK_H
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+
+// Playback position as the listener hears it. The audio callback publishes, per buffer, which
+// track sample starts the buffer and when it reaches the DAC (PortAudio's outputBufferDacTime);
+// any thread can then ask for the position right now, interpolated between callbacks.
+// Times are in the time source's base: the steady clock, or an audio backend's virtual clock.
+// Publishing is a seqlock: the callback never waits, and readers retry if they raced a publish.
+class AudioClock {
+public:
+    using TimeSource = std::function<double()>;
+
+    explicit AudioClock(int sampleRate = 48000) : rate(sampleRate), timeSource(&AudioClock::steadyNow) {}
+
+    void setSampleRate(int sampleRate) { rate = sampleRate; }
+    int sampleRate() const { return rate; }
+
+    // Set before the first publish; readers call it to find out what "now" is
+    void setTimeSource(TimeSource source) { timeSource = std::move(source); }
+    static double steadyNow();
+
+    // Audio thread: the buffer starting at track sample `position` holds `count` track samples
+    // and starts playing at dacTime
+    void publish(uint64_t position, uint64_t count, double dacTime);
+
+    // Any thread, with the stream stopped: the position holds still at `position`
+    void hold(uint64_t position);
+
+    // Track sample the listener hears right now
+    double position() const;
+    double seconds() const { return position() / rate; }
+
+private:
+    struct Snapshot {
+        uint64_t position;
+        uint64_t count;
+        uint64_t segmentStart;
+        double dacTime; // When `position` reaches the DAC
+        bool running;
+    };
+
+    void write(const Snapshot& snapshot);
+    Snapshot read() const;
+
+    int rate;
+    TimeSource timeSource;
+
+    std::atomic<uint32_t> sequence{0};
+    std::atomic<uint64_t> publishedPosition{0};
+    std::atomic<uint64_t> publishedCount{0};
+    std::atomic<uint64_t> publishedSegmentStart{0};
+    std::atomic<double> publishedDacTime{0.0};
+    std::atomic<bool> publishedRunning{false};
+
+    // Writer-side bookkeeping to find discontinuities (seeks)
+    uint64_t expectedNext = 0;
+    uint64_t segmentStart = 0;
+};
+
+#endif // AUDIO_CLOCK_H
@@ -2,53 +2,224 @@
 #ifndef AUDIO_PLAYER_H
 #define AUDIO_PLAYER_H
 
+#include "include/core/AudioBackend.h"
+#include "include/core/AudioClock.h"
+#include "include/core/BeatGrid.h"
+#include "include/core/SpscRingBuffer.h"
 #include <QObject>
-#include <portaudio.h>
+#include <atomic>
+#include <cstdint>
 #include <vector>
 #include <string>
+#include <memory>
+#include <thread>
 
+class DecodedAudio;
+class Metronome;
+class WaveformOverview;
+class QTimer;
+
+// Streaming playback: a feeder thread copies the track from the (memory-mapped) PCM into a
+// fixed-size lock-free ring buffer, and the PortAudio callback only copies out of that ring.
+// The audio thread never allocates, locks or touches the mapping, and playback memory is the
+// ring regardless of track length.
+// One output stream runs for the whole session. Play, pause and seek only flip atomics the
+// callback picks up on its next buffer, with short gain ramps and crossfades against clicks.
+// The stream comes from an AudioBackend: the sound card, or a null/offline device for headless runs.
 class AudioPlayer : public QObject {
     Q_OBJECT
 
 public:
-    AudioPlayer();
+    // Without a backend the one named by LEDSUIT_AUDIO_BACKEND is used (PortAudio by default)
+    explicit AudioPlayer(std::unique_ptr<AudioBackend> backend = nullptr);
     ~AudioPlayer();
 
-    // Load an audio file
+    // Load an audio file, resampled to the output device rate
     bool loadFile(const std::string& filepath);
 
-    // Playback controls
+    // Play already decoded PCM (shared with the analyzer); stops any running playback first.
+    // The PCM is expected at getSampleRate().
+    void setAudio(std::shared_ptr<const DecodedAudio> decoded);
+
+    // Playback controls; all take effect on the next audio buffer
     void play();
     void pause();
     void stop();
     void seek(double positionInSeconds);
 
-    // Get playback information
+    // Scrubbing: while active the callback plays short Hann-windowed grains around the scrub
+    // position instead of the transport, picking up each move within one grain hop (one buffer).
+    // scrubTo() only stores an atomic; endScrub() seeks to the last position and resumes play if
+    // the transport was playing before.
+    void beginScrub(double positionInSeconds);
+    void scrubTo(double positionInSeconds);
+    void endScrub();
+    bool isScrubbing() const { return scrubActive.load(std::memory_order_relaxed); }
+
+    // Loop region [startSample, endSample) at the device rate. Playback that reaches the end
+    // continues at the start within the same buffer, without a gap. Changing the region refills
+    // the buffered audio from the current position; an empty region turns looping off.
+    void setLoopRegion(uint64_t startSample, uint64_t endSample);
+    void clearLoopRegion() { setLoopRegion(0, 0); }
+    bool hasLoopRegion() const { return loopEnd.load(std::memory_order_relaxed) > 0; }
+    uint64_t getLoopStart() const { return loopStart.load(std::memory_order_relaxed); }
+    uint64_t getLoopEnd() const { return loopEnd.load(std::memory_order_relaxed); }
+
+    // Wraps played so far; bumps as the callback jumps back, together with the audio clock
+    uint64_t getLoopWrapCount() const { return loopWraps.load(std::memory_order_acquire); }
+
+    // Beat grid of the track at the device rate, cleared by setAudio(). The metronome clicks on it
+    // sample-exactly, also across loop wraps; the editor snaps waypoints to the same grid.
+    void setBeatGrid(const BeatGrid& grid);
+    const BeatGrid& getBeatGrid() const { return beatGrid; }
+    void setMetronomeEnabled(bool enabled);
+    bool isMetronomeEnabled() const { return metronomeEnabled.load(std::memory_order_relaxed); }
+    void setMetronomeGain(float gain);
+
+    // Get playback information. The current time is what the listener hears right now
+    // (DAC side, including output latency), not how far the callback has read.
     double getCurrentTime() const;
     double getTotalDuration() const;
+    int getSampleRate() const { return sampleRate; } // Output device rate
+    const AudioBackend& getBackend() const { return *backend; }
+
+    // Callbacks that ran out of buffered samples before the end of the track
+    uint64_t getUnderrunCount() const { return underruns.load(std::memory_order_relaxed); }
 
     bool isPlaying() const { return isPlaying_; }
 
-    // Waveform data extraction
+    // Peak envelope of the whole track in sampleCount columns (empty until a waveform is set)
+    void setWaveform(std::shared_ptr<const WaveformOverview> overview);
     std::vector<float> getWaveformData(size_t sampleCount) const;
 
 signals:
     void playbackFinished(); // Signal emitted when playback completes
     void playbackPositionChanged(double currentTime);
+    void loopWrapped(double loopStartSeconds); // From the playback monitor, after one or more wraps
                              
 
 private:
+    static constexpr size_t kCrossfadeSamples = 256; // Seek crossfade, ~5 ms at 48 kHz
+    static constexpr size_t kGrainLength = 1024;     // Scrub grain, ~21 ms at 48 kHz
+    static constexpr size_t kGrainHop = 256;         // New grain every buffer; 4 overlap
+    static constexpr size_t kMaxGrains = kGrainLength / kGrainHop;
+    static constexpr uint64_t kMinLoopSamples = 1024;  // Bounds the wrap markers the ring can hold
+
+    // Feeder -> callback: after streamIndex samples of the ring (counted since the last seek),
+    // playback continues at track sample target
+    struct WrapMarker {
+        uint64_t streamIndex;
+        uint64_t target;
+    };
+
+    // Track samples of the latest scrub position, copied out of the mapping by the UI thread.
+    // The callback copies each new grain from the live window, so it never reads the track itself.
+    struct ScrubWindow {
+        float samples[kGrainLength] = {}; // Track samples from the grain start on, zero past the end
+        uint64_t retiredAt = 0;           // publishEpoch that replaced it (see publishEpoch)
+    };
+    static constexpr size_t kScrubWindows = 8; // Rotated, so scrubbing never allocates
+
     // Internal variables
-    PaStream* audioStream;
+    std::unique_ptr<AudioBackend> backend; // Opened once and kept running; silent while paused
     std::string audioFilePath;
-    double currentTime;       // Current playback time in seconds
     double totalDuration;     // Total audio duration in seconds
     bool isPlaying_;
-    // Waveform data storage
-    std::vector<float> waveform;
+    int sampleRate;           // Stream rate, the default output device's native rate
+    // Decoded mono PCM, usually a read-only mapping of the decoded audio cache
+    std::shared_ptr<const DecodedAudio> audio;
+    std::atomic<uint64_t> trackSamples{0}; // audio->sampleCount(), readable by the callback without touching audio
+    std::shared_ptr<const WaveformOverview> waveform; // Of the current track, once the loader has built it
+    QTimer* playbackMonitor;   // Reports the end of the track and underruns while playing
+    uint64_t reportedUnderruns = 0;
+
+    // Transport, written by the UI thread and applied by the callback
+    std::atomic<bool> transportPlaying{false};
+    std::atomic<bool> trackFinished{false};
+
+    // Feeder thread -> audio callback
+    SpscRingBuffer<float> ring;
+    std::thread feeder;
+    std::atomic<bool> feederRunning{false};
+    uint64_t feedPosition = 0;               // Next sample the feeder writes (feeder thread only)
+    std::atomic<uint64_t> playPosition{0};   // Samples handed to the device so far
+    std::atomic<uint64_t> underruns{0};
+    SpscRingBuffer<WrapMarker> wrapMarkers;  // Written before the samples they refer to
+    std::atomic<uint64_t> loopStart{0};      // UI thread, read by the feeder
+    std::atomic<uint64_t> loopEnd{0};        // 0: no loop
+    std::atomic<uint64_t> loopWraps{0};
+    uint64_t reportedLoopWraps = 0;
+    AudioClock clock;                        // Published by the callback, read by the UI
+
+    // Seek handshake while streaming: the UI bumps seekGeneration, the feeder parks and
+    // publishes the generation in feederParked, the callback drops the ring, moves
+    // playPosition and acknowledges in consumerGeneration, then the feeder resumes.
+    std::atomic<uint64_t> seekTarget{0};
+    std::atomic<uint64_t> seekGeneration{0};
+    std::atomic<uint64_t> feederParked{0};
+    std::atomic<uint64_t> consumerGeneration{0};
+
+    // Objects the callback reads are swapped by the UI thread, which then bumps publishEpoch. Every
+    // callback stores the epoch it started in to finishedEpoch when it returns, so whatever was
+    // replaced at epoch E is out of the callback's hands once finishedEpoch >= E.
+    std::atomic<uint64_t> publishEpoch{0};
+    std::atomic<uint64_t> finishedEpoch{0};
+
+    // Scrub, written by the UI thread and read by the callback
+    std::atomic<bool> scrubActive{false};
+    std::atomic<uint64_t> scrubTarget{0};
+    std::atomic<const ScrubWindow*> liveScrubWindow{nullptr};
+    ScrubWindow scrubWindows[kScrubWindows];         // UI thread fills, callback reads the live one
+    ScrubWindow* publishedScrubWindow = nullptr;     // UI thread
+    bool resumeAfterScrub = false;                   // UI thread
+
+    // Metronome; replaced grids are kept until the callback is done with them (see publishEpoch)
+    struct RetiredBeatGrid {
+        std::unique_ptr<const BeatGrid> grid;
+        uint64_t retiredAt;
+    };
+    std::unique_ptr<const Metronome> metronome;
+    BeatGrid beatGrid;                                 // UI thread
+    std::atomic<const BeatGrid*> liveBeatGrid{nullptr};
+    std::unique_ptr<const BeatGrid> publishedBeatGrid; // UI thread
+    std::vector<RetiredBeatGrid> retiredBeatGrids;     // UI thread
+    std::atomic<bool> metronomeEnabled{false};
+    std::atomic<float> metronomeGain{1.0f};
+
+    // Audio thread only: scrub grains in flight, each with its own copy of the window it started from
+    struct Grain {
+        float samples[kGrainLength];
+        size_t age;     // Samples played so far; kGrainLength when idle
+    };
+    float grainWindow[kGrainLength] = {};
+    Grain grains[kMaxGrains] = {};
+    size_t grainClock = 0; // Samples until the next grain starts
+
+    // Audio thread only: output gain for pause/resume ramps and the tail of the pre-seek audio
+    float gain = 0.0f;
+    float fadeTail[kCrossfadeSamples] = {};
+    size_t fadeTailLength = 0;
+    size_t fadeTailPosition = 0;
+    float fadeTailGain = 0.0f;
+    uint64_t streamRead = 0;     // Ring samples consumed since the last seek
+    WrapMarker nextWrap = {};
+    bool haveNextWrap = false;
 
     // Internal helpers
-    void extractWaveformData();
+    bool ensureStream();
+    void requestSeek(uint64_t target);
+    void checkPlayback();
+    void startFeeder();
+    void stopFeeder();
+    void settlePendingSeek(); // Applies a seek the callback did not pick up; feeder and stream stopped
+    void feedLoop();
+    bool renderAudio(float* out, unsigned long frames, double dacTime); // Audio thread
+    void renderClicks(float* out, uint64_t position, size_t count);     // Audio thread, adds to out
+    void renderScrub(float* out, unsigned long frames);                 // Audio thread, adds to out
+    uint64_t scrubSampleAt(double positionInSeconds) const;
+    uint64_t retire();                        // UI thread, after a swap: the epoch to wait for
+    bool callbackDone(uint64_t epoch) const;  // Nothing replaced at epoch is in use any more
+    ScrubWindow* freeScrubWindow();           // nullptr while the callback still holds all of them
 };
 
 #endif // AUDIO_PLAYER_H
@@ -3,20 +3,50 @@
 
 #include <vector>
 #include <string>
+#include <functional>
+#include <memory>
+#include <atomic>
+#include "include/core/SpectrogramBuffer.h"
+#include "include/core/SpectrumFilterbank.h"
+#include "include/core/DecodedAudioCache.h"
 
 class AudioPreprocessor {
 public:
+    // Called for every frame as soon as it is produced (log-binned magnitudes, not yet normalized)
+    using FrameCallback = std::function<void(size_t frameIndex, const float* bins, int binCount)>;
+
+    // FFTW planner effort; the cost is paid once per machine thanks to the wisdom file
+    enum class PlannerRigor { Measure, Patient };
+
     AudioPreprocessor();
     ~AudioPreprocessor();
 
-    // Load audio file and prepare for processing
+    // Import FFTW wisdom from filepath; newly measured plans are exported back to the same file
+    static bool loadFftwWisdom(const std::string& filepath);
+    // Set from appconfig.json ("fftwPlanner") before the first analysis; existing plans are kept
+    static void setPlannerRigor(PlannerRigor rigor);
+
+    // Everything that influences the analysis output, used to key cached spectrograms
+    static std::string analysisSignature(int sampleRate, int fftSize, int maxFrequency);
+
+    // Load audio file (any channel count, through the decoded audio cache) and prepare for processing
     bool loadFile(const std::string& filepath, int sampleRate = 48000, int fftSize = 1024);
 
-    // Generate spectrogram data
-    void computeSpectrogram(int maxFrequency = 1000);
+    // Analyze PCM that is already decoded, e.g. the mapping the player is using
+    void setAudio(std::shared_ptr<const DecodedAudio> decoded, int sampleRate = 48000, int fftSize = 1024);
+
+    // Generate spectrogram data, normalized and display-scaled into [0, 1] (what the view draws and
+    // the cache stores); onFrame sees every raw frame in order, batch by batch
+    bool computeSpectrogram(int maxFrequency = 1000, const FrameCallback& onFrame = nullptr);
 
-    // Get spectrogram data for GUI
-    const std::vector<std::vector<float>>& getSpectrogram() const;
+    // computeSpectrogram() gives up and returns false as soon as the flag is set; nullptr disables
+    void setCancelFlag(const std::atomic<bool>* flag) { cancelFlag = flag; }
+
+    // Logarithmic display scaling of normalized magnitudes, in place; the last step of the analysis
+    static void applyDisplayScaling(float* row, size_t bins);
+
+    // Hand the spectrogram (time-major, one row per frame) over to the GUI without copying
+    std::shared_ptr<SpectrogramBuffer> takeSpectrogram();
 
     // Map time to spectrogram frame
     size_t getFrameIndexForTime(double timeInSeconds) const;
@@ -27,13 +57,28 @@ public:
     int getTimeFrames() const;
 
 private:
-    std::vector<float> audioSamples;                  // Raw audio data
-    std::vector<std::vector<float>> spectrogramData;  // 2D spectrogram matrix
+    // Analysis steps, used by computeSpectrogram()
+    static void computeBinLayout(int sampleRate, int fftSize, int maxFrequency, int& maxBin, int& logBins);
+    void prepareAnalysis(int maxFrequency);
+    void applyWindow(const float* samples, float* inputBuffer) const;
+    float mapToLogBins(const float* fftOutput /* interleaved complex */, float* linearSpectrum,
+                       double* bandScratch, float* frameBins) const; // Returns the frame maximum
+    float analyzeFrames(const float* samples, size_t firstFrame, size_t frameCount); // Multi-threaded, returns the max magnitude
+    void normalizeSpectrogram(float maxMagnitude);
+
+    std::shared_ptr<const DecodedAudio> audio;        // Mono PCM, shared with the player
+    std::shared_ptr<SpectrogramBuffer> spectrogram;   // 2D spectrogram matrix
     double duration;                                  // Duration in seconds
     int sampleRate;                                   // Audio sample rate
     int fftSize;                                      // FFT size
     int hopSize;                                      // Frame hop size (e.g., fftSize / 2)
+    const std::atomic<bool>* cancelFlag = nullptr;    // Set by the owner to abort the analysis
+
+    // Analysis layout, rebuilt by prepareAnalysis()
+    int maxBin = 0;                                   // Highest linear FFT bin that is kept
+    int logBins = 0;                                  // Number of logarithmic output bins
+    std::shared_ptr<const SpectrumFilterbank> filterbank; // Linear bins -> log bands, shared between runs
+    std::vector<float> window;                        // Hann window
 };
 
 #endif // AUDIO_PREPROCESSOR_H
-
@@ -0,0 +1,53 @@
+#ifndef AUDIO_STREAM_READER_H
+#define AUDIO_STREAM_READER_H
+
+#include "include/core/PolyphaseResampler.h"
+#include "include/core/SeekIndex.h"
+#include <QString>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+struct sf_private_tag; // libsndfile's SNDFILE
+
+// Decodes a track on demand, block by block, into the same mono samples at the output rate that
+// the decoded audio cache produces, for playback that does not wait for the whole file.
+// seek() jumps through the track's seek index: sf_seek to the checkpoint (libsndfile uses the FLAC
+// seek table / the MP3 frame index for that), restart the resampler from the stored history and
+// decode less than one index interval to reach the exact sample. Not thread-safe.
+class AudioStreamReader {
+public:
+    AudioStreamReader(const QString& audioFilePath, std::shared_ptr<const SeekIndex> index);
+    ~AudioStreamReader();
+
+    AudioStreamReader(const AudioStreamReader&) = delete;
+    AudioStreamReader& operator=(const AudioStreamReader&) = delete;
+
+    bool isOpen() const { return sndfile != nullptr; }
+    uint64_t position() const { return outputPosition; } // Next output sample read() returns
+    uint64_t length() const { return index ? index->outputSamples() : 0; }
+
+    // Returns false if the file cannot be repositioned; the reader is then at the start
+    bool seek(uint64_t outputSample);
+
+    // Up to count output samples; fewer only at the end of the track
+    size_t read(float* out, size_t count);
+
+private:
+    bool decodeBlock(); // Appends converted samples to pending; false at the end
+    void rewind();
+
+    sf_private_tag* sndfile = nullptr;
+    int channels = 1;
+    std::shared_ptr<const SeekIndex> index;
+    std::unique_ptr<PolyphaseResampler> resampler;
+
+    std::vector<float> block;       // Interleaved source frames
+    std::vector<float> mono;
+    std::vector<float> pending;     // Converted, not yet returned
+    size_t pendingOffset = 0;
+    uint64_t outputPosition = 0;
+    bool finished = false;          // Source exhausted and resampler flushed
+};
+
+#endif // AUDIO_STREAM_READER_H
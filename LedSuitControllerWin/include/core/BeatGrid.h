@@ -0,0 +1,43 @@
+#ifndef BEAT_GRID_H
+#define BEAT_GRID_H
+
+#include <cstdint>
+
+// Tempo map of a track: a constant tempo starting at a first beat, in samples at the output rate.
+// Beat n lies at firstBeat + round(n * samplesPerBeat), computed from n directly, so no error
+// accumulates over a long track and every user (the metronome in the audio callback, waypoint
+// snapping in the editor) lands on the same sample for the same beat. Subdivisions split the span
+// between two beats, so a quantized waypoint on a beat is exactly that beat's sample.
+// Immutable value type, safe to share with the audio thread.
+class BeatGrid {
+public:
+    BeatGrid() = default;
+    BeatGrid(double bpm, double firstBeatSeconds, int beatsPerBar, int sampleRate);
+
+    bool isValid() const { return period > 0.0; }
+    double bpm() const { return tempo; }
+    int beatsPerBar() const { return barLength; }
+    int sampleRate() const { return rate; }
+    int64_t firstBeatSample() const { return firstBeat; }
+    double firstBeatSeconds() const;
+    double samplesPerBeat() const { return period; }
+
+    // Beats are numbered from the first one; negative beats lie before it
+    int64_t beatSample(int64_t beat) const;
+    // Last beat at or before sample
+    int64_t beatAtOrBefore(int64_t sample) const;
+    bool isDownbeat(int64_t beat) const;
+
+    // Nearest 1/subdivision of a beat to sample, and the same by time
+    int64_t quantize(int64_t sample, int subdivision = 1) const;
+    double quantizeTime(double seconds, int subdivision = 1) const;
+
+private:
+    double tempo = 0.0;
+    double period = 0.0; // Samples per beat, fractional
+    int64_t firstBeat = 0;
+    int barLength = 4;
+    int rate = 0;
+};
+
+#endif // BEAT_GRID_H
@@ -0,0 +1,69 @@
+#ifndef DECODED_AUDIO_CACHE_H
+#define DECODED_AUDIO_CACHE_H
+
+#include <QString>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+class SeekIndex;
+
+// Mono float32 PCM of one track at the rate it was requested with. Normally backed by a read-only mapping of a cache file, so the
+// player and the analyzer read the same pages and a reopened track needs no decoding at all.
+class DecodedAudio {
+public:
+    DecodedAudio(const float* samples, size_t sampleCount, int sampleRate, QString contentHash,
+                 std::shared_ptr<void> keepAlive);
+
+    DecodedAudio(const DecodedAudio&) = delete;
+    DecodedAudio& operator=(const DecodedAudio&) = delete;
+
+    const float* samples() const { return sampleData; }
+    size_t sampleCount() const { return count; }
+    int sampleRate() const { return rate; }
+    double duration() const { return rate > 0 ? static_cast<double>(count) / rate : 0.0; }
+
+    // Hash of the source file contents, also usable as a key for derived data
+    const QString& contentHash() const { return hash; }
+
+private:
+    const float* sampleData;
+    size_t count;
+    int rate;
+    QString hash;
+    std::shared_ptr<void> storage; // Mapping (or fallback vector) that owns sampleData
+};
+
+// Decodes a file once into <cacheDirectory>/<hash>.pcm and maps it. Decoding runs every block
+// through the conversion stage (vectorized downmix of any channel count, then polyphase resampling
+// to the requested rate), so player and analyzer get identical samples at the device rate.
+// Tracks that are still open anywhere in the process are handed out again instead of being mapped twice.
+// Every entry comes with a seek index (<hash>.seek) built during the same decode pass.
+class DecodedAudioCache {
+public:
+    explicit DecodedAudioCache(const QString& cacheDirectory = defaultDirectory());
+
+    static QString defaultDirectory();
+
+    // Hash of the file contents, the decoder version and the output rate; empty if the file cannot be read
+    static QString makeKey(const QString& audioFilePath, int sampleRate);
+
+    // sampleRate 0 keeps the file's own rate. Returns nullptr if the file cannot be decoded
+    // or cancel is set while decoding.
+    std::shared_ptr<const DecodedAudio> open(const QString& audioFilePath, int sampleRate = 0,
+                                             const std::atomic<bool>* cancel = nullptr) const;
+
+    // Seek index of a track that was opened (decoded) before; nullptr if there is none yet
+    std::shared_ptr<const SeekIndex> openSeekIndex(const QString& audioFilePath, int sampleRate = 0) const;
+
+private:
+    QString entryPath(const QString& key) const;
+    QString seekIndexPath(const QString& key) const;
+    std::shared_ptr<const DecodedAudio> load(const QString& key) const;
+    std::shared_ptr<const DecodedAudio> decode(const QString& audioFilePath, const QString& key, int sampleRate,
+                                               const std::atomic<bool>* cancel) const;
+
+    QString directory;
+};
+
+#endif // DECODED_AUDIO_CACHE_H
@@ -0,0 +1,27 @@
+#ifndef METRONOME_H
+#define METRONOME_H
+
+#include "include/core/BeatGrid.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Click track for a beat grid. The two clicks (a higher one on the downbeat) are synthesized once;
+// mix() adds the parts of the clicks that fall into a run of consecutive track samples, so the
+// audio callback can render any buffer, or the piece of a buffer between two loop wraps, without
+// keeping state between calls. Allocation-free after construction.
+class Metronome {
+public:
+    explicit Metronome(int sampleRate);
+
+    size_t clickLength() const { return accentClick.size(); }
+
+    // Adds the clicks sounding at track samples [position, position + count) to out
+    void mix(const BeatGrid& grid, uint64_t position, float* out, size_t count, float gain) const;
+
+private:
+    std::vector<float> accentClick;
+    std::vector<float> beatClick;
+};
+
+#endif // METRONOME_H
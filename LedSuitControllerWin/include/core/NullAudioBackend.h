@@ -0,0 +1,74 @@
+#ifndef NULL_AUDIO_BACKEND_H
+#define NULL_AUDIO_BACKEND_H
+
+#include "include/core/AudioBackend.h"
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+// No device: a worker thread pulls buffers and advances a virtual clock by their length.
+// speed > 0 paces the clock at that multiple of real time, speed <= 0 runs as fast as possible.
+// When the player cannot fill a buffer the clock waits instead of rendering silence, so the
+// output only depends on the transport calls, not on thread scheduling.
+class NullAudioBackend : public AudioBackend {
+public:
+    explicit NullAudioBackend(int sampleRate = 48000, double speed = 0.0);
+    ~NullAudioBackend() override;
+
+    const char* name() const override { return "null"; }
+    int preferredSampleRate() const override { return rate; }
+    bool isRealTime() const override { return false; }
+
+    bool open(int sampleRate, unsigned long framesPerBuffer, RenderCallback render) override;
+    void close() override;
+    bool isOpen() const override { return running.load(); }
+
+    double outputLatency() const override { return 0.0; }
+    double now() const override;
+
+    uint64_t framesRendered() const { return renderedFrames.load(std::memory_order_acquire); }
+
+protected:
+    // Every rendered buffer, on the worker thread
+    virtual void deliver(const float* /*buffer*/, unsigned long /*frames*/) {}
+
+private:
+    void run();
+
+    int rate;
+    double speed;
+    unsigned long bufferFrames = 0;
+    RenderCallback renderCallback;
+    std::thread worker;
+    std::atomic<bool> running{false};
+    std::atomic<uint64_t> renderedFrames{0};
+};
+
+// Null backend that also keeps everything it renders, for end-to-end checks and benchmarks.
+// With a file path the output is written there as a 32-bit float WAV on close().
+class OfflineAudioBackend : public NullAudioBackend {
+public:
+    explicit OfflineAudioBackend(const std::string& wavPath = std::string(), int sampleRate = 48000,
+                                 double speed = 0.0);
+    ~OfflineAudioBackend() override;
+
+    const char* name() const override { return "offline"; }
+    void close() override;
+
+    // Output rendered so far; only valid after close()
+    const std::vector<float>& rendered() const { return output; }
+
+protected:
+    void deliver(const float* buffer, unsigned long frames) override;
+
+private:
+    bool writeWav() const;
+
+    std::string wavPath;
+    std::vector<float> output;
+    bool written = false;
+};
+
+#endif // NULL_AUDIO_BACKEND_H
@@ -0,0 +1,50 @@
+#ifndef POLYPHASE_RESAMPLER_H
+#define POLYPHASE_RESAMPLER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Streaming rational sample-rate converter (e.g. 44.1 kHz -> 48 kHz is 160/147) for mono float PCM.
+// Uses a Kaiser-windowed sinc with tapsPerPhase taps for each of the upsampling phases, so every
+// output sample is one short dot product. The cutoff sits just below the lower of the two Nyquist rates.
+class PolyphaseResampler {
+public:
+    PolyphaseResampler(int inputRate, int outputRate, int tapsPerPhase = 64);
+
+    bool isPassthrough() const { return upFactor == downFactor; }
+    int upsampling() const { return upFactor; }
+    int downsampling() const { return downFactor; }
+
+    // Number of output samples for inputCount input samples
+    uint64_t outputLength(uint64_t inputCount) const;
+
+    // Appends every output sample that can be computed from the input so far
+    void process(const float* input, size_t count, std::vector<float>& output);
+
+    // Pads the input with silence and appends the remaining output samples
+    void flush(std::vector<float>& output);
+
+    // Input samples before a restart point that the first outputs after it still reach
+    int historyLength() const { return taps / 2 - 1; }
+
+    // Continues as if everything before inputPosition had been processed: `previous` holds the
+    // historyLength() input samples before it. inputPosition must be a multiple of downsampling(),
+    // so the next output sample is exactly the one a full run would produce there.
+    void restart(uint64_t inputPosition, const float* previous);
+
+private:
+    void emitAvailable(std::vector<float>& output);
+
+    int upFactor;
+    int downFactor;
+    int taps;
+    std::vector<float> coefficients; // upFactor phases x taps, each phase normalized to unity gain
+
+    std::vector<float> history;      // Input samples from historyStart on
+    int64_t historyStart;            // Absolute input index of history[0] (negative: leading silence)
+    uint64_t inputConsumed = 0;      // Input samples received so far
+    uint64_t nextOutput = 0;         // Absolute index of the next output sample
+};
+
+#endif // POLYPHASE_RESAMPLER_H
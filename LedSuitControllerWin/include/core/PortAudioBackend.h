@@ -0,0 +1,35 @@
+#ifndef PORTAUDIO_BACKEND_H
+#define PORTAUDIO_BACKEND_H
+
+#include "include/core/AudioBackend.h"
+#include <portaudio.h>
+
+// The default output device through PortAudio. DAC times come from outputBufferDacTime, rebased
+// onto the steady clock; hosts that report none fall back to the stream's output latency.
+class PortAudioBackend : public AudioBackend {
+public:
+    PortAudioBackend();  // Throws if PortAudio cannot be initialized
+    ~PortAudioBackend() override;
+
+    const char* name() const override { return "portaudio"; }
+    int preferredSampleRate() const override { return deviceRate; }
+    bool isRealTime() const override { return true; }
+
+    bool open(int sampleRate, unsigned long framesPerBuffer, RenderCallback render) override;
+    void close() override;
+    bool isOpen() const override { return stream != nullptr; }
+
+    double outputLatency() const override { return latency; }
+    double now() const override;
+
+private:
+    static int streamCallback(const void* input, void* output, unsigned long frames,
+                              const PaStreamCallbackTimeInfo* timeInfo, PaStreamCallbackFlags flags, void* userData);
+
+    PaStream* stream = nullptr;
+    RenderCallback renderCallback;
+    int deviceRate = 48000;
+    double latency = 0.0;
+};
+
+#endif // PORTAUDIO_BACKEND_H
@@ -0,0 +1,63 @@
+#ifndef SEEK_INDEX_H
+#define SEEK_INDEX_H
+
+#include <QString>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Restart points for decoding a track from the middle. Checkpoints sit every interval() source
+// frames, on frames where the resampler's output lines up exactly with its input, and keep the
+// mono source samples the resampler needs from before the checkpoint. Finding the checkpoint for
+// an output sample is a division, so a streaming decoder repositions in constant time: seek the
+// file to the checkpoint, restart the resampler from its history, skip less than one interval.
+class SeekIndex {
+public:
+    struct Point {
+        uint64_t sourceFrame;  // First source frame after the checkpoint
+        uint64_t outputSample; // Output sample produced at sourceFrame
+        const float* history;  // historyLength() mono source samples before sourceFrame
+    };
+
+    SeekIndex() = default;
+    // Checkpoints land on multiples of `alignment` source frames (the resampler's downsampling factor)
+    SeekIndex(int sourceRate, int outputRate, int alignment, int historyLength);
+
+    // Decoder side: every downmixed source sample, in order
+    void append(const float* mono, size_t count);
+    void finish(uint64_t outputSamples);
+
+    bool empty() const { return frames.empty(); }
+    size_t size() const { return frames.size(); }
+    int sourceRate() const { return sourceRateHz; }
+    int outputRate() const { return outputRateHz; }
+    uint64_t interval() const { return intervalFrames; }
+    int historyLength() const { return historySize; }
+    uint64_t sourceFrames() const { return totalSourceFrames; }
+    uint64_t outputSamples() const { return totalOutputSamples; }
+
+    Point point(size_t index) const;
+    // Last checkpoint at or before outputSample
+    Point locate(uint64_t outputSample) const;
+
+    // Stored next to the decoded PCM; load() returns false for missing or incompatible files
+    bool save(const QString& path) const;
+    bool load(const QString& path);
+
+private:
+    int sourceRateHz = 0;
+    int outputRateHz = 0;
+    int historySize = 0;
+    uint64_t intervalFrames = 0;     // Source frames between checkpoints
+    uint64_t outputInterval = 0;     // Output samples between checkpoints
+    std::vector<uint64_t> frames;    // Source frame of every checkpoint
+    std::vector<uint64_t> outputs;   // Output sample of every checkpoint
+    std::vector<float> histories;    // size() x historyLength()
+
+    // Builder state
+    std::vector<float> recent;       // The historyLength() source samples before totalSourceFrames
+    uint64_t totalSourceFrames = 0;
+    uint64_t totalOutputSamples = 0;
+};
+
+#endif // SEEK_INDEX_H
@@ -0,0 +1,50 @@
+#ifndef SIMD_KERNELS_H
+#define SIMD_KERNELS_H
+
+#include <cstddef>
+
+// Vectorized inner loops for the spectrogram pipeline. The implementation is picked once at runtime
+// (AVX2+FMA, SSE4.1 or a scalar fallback), so the binary still runs on machines without AVX2.
+// The vector paths use a fast polynomial log; results agree with the scalar std:: reference to ~1e-6.
+namespace simd {
+
+enum class InstructionSet { Scalar, SSE41, AVX2 };
+
+InstructionSet activeInstructionSet();
+const char* instructionSetName(InstructionSet set);
+
+// Restrict dispatch to at most the given set (used to compare against the scalar reference)
+void limitInstructionSet(InstructionSet maximum);
+
+// out[i] = a[i] * b[i]
+void multiply(const float* a, const float* b, float* out, size_t count);
+
+// out[i] = |interleaved[2i] + j * interleaved[2i + 1]|
+void complexMagnitude(const float* interleaved, float* out, size_t count);
+
+// Sum and maximum of a range
+float sum(const float* data, size_t count);
+float max(const float* data, size_t count);
+
+// Sum of a[i] * b[i]
+float dot(const float* a, const float* b, size_t count);
+
+// data[i] = log10(1 + data[i]) * scale
+void log10OnePlus(float* data, size_t count, float scale);
+
+// data[i] = (log10(max(data[i], floor)) - offset) * scale
+void log10Remap(float* data, size_t count, float floor, float offset, float scale);
+
+// out[i] = average of the channels of interleaved frame i (any channel count >= 1)
+void downmix(const float* interleaved, float* out, size_t frames, int channels);
+
+// Minimum, maximum and sum of squares of each blockSize-sample block (the last one may be shorter);
+// the outputs hold ceil(count / blockSize) entries
+void blockStats(const float* data, size_t count, size_t blockSize, float* mins, float* maxs, float* energies);
+
+// out[i] += in[i] * gain
+void mixAdd(const float* in, float* out, size_t count, float gain);
+
+} // namespace simd
+
+#endif // SIMD_KERNELS_H
@@ -0,0 +1,96 @@
+#ifndef SPECTROGRAM_BUFFER_H
+#define SPECTROGRAM_BUFFER_H
+
+#include <cstddef>
+#include <memory>
+
+// Flat, row-major spectrogram storage: one row per time frame, one column per frequency bin.
+// Rows are padded to a multiple of 16 floats so every row starts on a 64-byte boundary.
+// Producers and consumers share the buffer through a pointer; nothing is transposed or copied.
+class SpectrogramBuffer {
+public:
+    static constexpr size_t kAlignment = 64;
+
+    // Time-major access: contiguous rows, view(frame, bin)
+    class TimeMajorView {
+    public:
+        TimeMajorView(const float* data, size_t frames, size_t bins, size_t stride)
+            : data(data), frameCount(frames), binCount(bins), rowStride(stride) {}
+
+        const float* frame(size_t t) const { return data + t * rowStride; }
+        float operator()(size_t t, size_t bin) const { return data[t * rowStride + bin]; }
+        size_t frames() const { return frameCount; }
+        size_t bins() const { return binCount; }
+
+    private:
+        const float* data;
+        size_t frameCount;
+        size_t binCount;
+        size_t rowStride;
+    };
+
+    // Frequency-major access over the same memory: view(bin, frame), strided by the row stride
+    class FrequencyMajorView {
+    public:
+        FrequencyMajorView(const float* data, size_t frames, size_t bins, size_t stride)
+            : data(data), frameCount(frames), binCount(bins), rowStride(stride) {}
+
+        float operator()(size_t bin, size_t t) const { return data[t * rowStride + bin]; }
+        size_t frames() const { return frameCount; }
+        size_t bins() const { return binCount; }
+        size_t stride() const { return rowStride; }
+
+    private:
+        const float* data;
+        size_t frameCount;
+        size_t binCount;
+        size_t rowStride;
+    };
+
+    SpectrogramBuffer() = default;
+    SpectrogramBuffer(size_t frames, size_t bins);
+
+    // Wraps storage owned by someone else (e.g. a memory-mapped file); keepAlive is held until the buffer dies
+    SpectrogramBuffer(float* data, size_t frames, size_t bins, size_t stride, std::shared_ptr<void> keepAlive);
+
+    SpectrogramBuffer(const SpectrogramBuffer&) = delete;
+    SpectrogramBuffer& operator=(const SpectrogramBuffer&) = delete;
+    SpectrogramBuffer(SpectrogramBuffer&& other) noexcept;
+    SpectrogramBuffer& operator=(SpectrogramBuffer&& other) noexcept;
+
+    size_t frames() const { return frameCount; }
+    size_t bins() const { return binCount; }
+    size_t stride() const { return rowStride; }
+    bool empty() const { return frameCount == 0 || binCount == 0; }
+    size_t sizeInBytes() const { return frameCount * rowStride * sizeof(float); }
+
+    float* data() { return storage; }
+    const float* data() const { return storage; }
+    float* row(size_t frame) { return storage + frame * rowStride; }
+    const float* row(size_t frame) const { return storage + frame * rowStride; }
+    float& at(size_t frame, size_t bin) { return storage[frame * rowStride + bin]; }
+    float at(size_t frame, size_t bin) const { return storage[frame * rowStride + bin]; }
+
+    TimeMajorView timeMajor() const { return TimeMajorView(storage, frameCount, binCount, rowStride); }
+    FrequencyMajorView frequencyMajor() const { return FrequencyMajorView(storage, frameCount, binCount, rowStride); }
+
+    // Grow or shrink the number of frames, keeping existing rows; new rows are zeroed
+    void reserveFrames(size_t capacity);
+    void resizeFrames(size_t frames);
+
+    // Row stride in floats for a given bin count (a multiple of the 64-byte alignment)
+    static size_t strideFor(size_t bins);
+
+private:
+    void reallocate(size_t capacity);
+
+    std::shared_ptr<void> owner;  // Aligned heap block or external mapping
+    float* storage = nullptr;
+    size_t frameCount = 0;
+    size_t binCount = 0;
+    size_t rowStride = 0;
+    size_t frameCapacity = 0;
+    bool ownsStorage = false;     // External storage cannot be resized
+};
+
+#endif // SPECTROGRAM_BUFFER_H
@@ -0,0 +1,33 @@
+#ifndef SPECTROGRAM_CACHE_H
+#define SPECTROGRAM_CACHE_H
+
+#include "include/core/SpectrogramBuffer.h"
+#include <QString>
+#include <memory>
+#include <string>
+
+// Persistent store of computed spectrograms. Entries are keyed by the audio file contents plus the
+// analysis parameters and are kept in a memory-mappable binary format, so a hit needs no FFT at all.
+class SpectrogramCache {
+public:
+    explicit SpectrogramCache(const QString& cacheDirectory);
+
+    // Hash of the file contents and the analysis signature; empty if the file cannot be read
+    static QString makeKey(const QString& audioFilePath, const std::string& analysisSignature);
+
+    // Same, for audio whose contents were already hashed (see DecodedAudio::contentHash())
+    static QString makeKeyFromHash(const QString& contentHash, const std::string& analysisSignature);
+
+    // Maps a cached spectrogram copy-on-write; returns nullptr on a miss or a damaged entry
+    std::shared_ptr<SpectrogramBuffer> load(const QString& key, double& audioDuration) const;
+
+    // Writes an entry atomically (temporary file + rename)
+    bool store(const QString& key, const SpectrogramBuffer& spectrogram, double audioDuration) const;
+
+private:
+    QString entryPath(const QString& key) const;
+
+    QString directory;
+};
+
+#endif // SPECTROGRAM_CACHE_H
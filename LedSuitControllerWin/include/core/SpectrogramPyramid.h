@@ -0,0 +1,31 @@
+#ifndef SPECTROGRAM_PYRAMID_H
+#define SPECTROGRAM_PYRAMID_H
+
+#include "include/core/SpectrogramBuffer.h"
+#include <memory>
+#include <vector>
+
+// Mip pyramid over the time axis of a spectrogram. Level 0 is the full-resolution buffer and
+// every further level halves the number of frames, so any zoom level can be drawn from a level
+// whose frame count is close to the number of on-screen columns.
+class SpectrogramPyramid {
+public:
+    enum class Aggregation { Max, Mean };
+
+    SpectrogramPyramid() = default;
+    explicit SpectrogramPyramid(std::shared_ptr<SpectrogramBuffer> base, Aggregation aggregation = Aggregation::Max);
+
+    bool empty() const { return levels.empty(); }
+    size_t levelCount() const { return levels.size(); }
+    const SpectrogramBuffer& level(size_t index) const { return *levels[index]; }
+    // For readers on other threads that must keep the level alive
+    std::shared_ptr<const SpectrogramBuffer> sharedLevel(size_t index) const { return levels[index]; }
+
+    // Coarsest level that still has at least one frame per on-screen column
+    size_t levelForFramesPerPixel(float framesPerPixel) const;
+
+private:
+    std::vector<std::shared_ptr<SpectrogramBuffer>> levels;
+};
+
+#endif // SPECTROGRAM_PYRAMID_H
@@ -0,0 +1,55 @@
+#ifndef SPECTRUM_FILTERBANK_H
+#define SPECTRUM_FILTERBANK_H
+
+#include <memory>
+#include <string>
+#include <vector>
+
+// Maps a linear magnitude spectrum (bins 0..inputBins()-1) onto a smaller set of bands.
+// Filterbanks are built once per parameter set and shared; every band covers at least one bin,
+// so no output row is ever empty. Rectangular bands are averaged from a prefix-sum array,
+// weighted (mel) bands are applied as a sparse mat-vec, both in a single pass per frame.
+class SpectrumFilterbank {
+public:
+    enum class Scale { Logarithmic, Mel, Custom };
+
+    struct Band {
+        int firstBin = 0;
+        int binCount = 0;
+        std::vector<float> weights; // Empty for a rectangular (plain average) band
+    };
+
+    // Cached, log-spaced rectangular bands from DC to maxFrequency
+    static std::shared_ptr<const SpectrumFilterbank> logarithmic(int fftSize, int sampleRate, int maxFrequency, int bandCount);
+
+    // Cached, triangular mel bands from 0 Hz to maxFrequency (weights of each band sum to 1)
+    static std::shared_ptr<const SpectrumFilterbank> mel(int fftSize, int sampleRate, int maxFrequency, int bandCount);
+
+    // Cached, rectangular bands between consecutive edge frequencies in Hz (edges.size() - 1 bands)
+    static std::shared_ptr<const SpectrumFilterbank> custom(int fftSize, int sampleRate, const std::vector<float>& edgesHz);
+
+    int bandCount() const { return static_cast<int>(bandList.size()); }
+    int inputBins() const { return binCount; }
+    Scale scale() const { return bankScale; }
+    const std::vector<Band>& bands() const { return bandList; }
+
+    // Identifies the exact band layout, e.g. for cache keys
+    const std::string& signature() const { return layoutSignature; }
+
+    // Scratch values apply() needs per concurrent caller (the prefix-sum array)
+    size_t scratchSize() const { return static_cast<size_t>(binCount) + 1; }
+
+    // out[b] = weighted average of spectrum over band b; returns the largest band value
+    float apply(const float* spectrum, float* out, double* scratch) const;
+
+private:
+    SpectrumFilterbank(Scale scale, int inputBins, std::vector<Band> bands, std::string signature);
+
+    Scale bankScale;
+    int binCount;
+    bool hasWeightedBands;
+    std::vector<Band> bandList;
+    std::string layoutSignature;
+};
+
+#endif // SPECTRUM_FILTERBANK_H
@@ -0,0 +1,92 @@
+#ifndef SPSC_RING_BUFFER_H
+#define SPSC_RING_BUFFER_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+// Lock-free single-producer/single-consumer ring buffer for trivially copyable samples.
+// One thread only writes, one thread only reads; neither side ever blocks or allocates,
+// so the consumer side is safe to use from a real-time audio callback.
+// The capacity is rounded up to a power of two so wrapping is a mask.
+template <typename T>
+class SpscRingBuffer {
+public:
+    explicit SpscRingBuffer(size_t minimumCapacity) {
+        capacity = 1;
+        while (capacity < minimumCapacity) {
+            capacity <<= 1;
+        }
+        mask = capacity - 1;
+        buffer.reset(new T[capacity]());
+    }
+
+    SpscRingBuffer(const SpscRingBuffer&) = delete;
+    SpscRingBuffer& operator=(const SpscRingBuffer&) = delete;
+
+    size_t size() const { return capacity; }
+
+    // Producer side: copies up to count items, returns how many fit
+    size_t write(const T* items, size_t count) {
+        const size_t head = writeIndex.load(std::memory_order_relaxed);
+        const size_t tail = readIndex.load(std::memory_order_acquire);
+        count = std::min(count, capacity - (head - tail));
+
+        const size_t offset = head & mask;
+        const size_t firstPart = std::min(count, capacity - offset);
+        std::copy(items, items + firstPart, buffer.get() + offset);
+        std::copy(items + firstPart, items + count, buffer.get());
+
+        writeIndex.store(head + count, std::memory_order_release);
+        return count;
+    }
+
+    // Consumer side: copies up to count items, returns how many were available
+    size_t read(T* items, size_t count) {
+        const size_t tail = readIndex.load(std::memory_order_relaxed);
+        const size_t head = writeIndex.load(std::memory_order_acquire);
+        count = std::min(count, head - tail);
+
+        const size_t offset = tail & mask;
+        const size_t firstPart = std::min(count, capacity - offset);
+        std::copy(buffer.get() + offset, buffer.get() + offset + firstPart, items);
+        std::copy(buffer.get(), buffer.get() + (count - firstPart), items + firstPart);
+
+        readIndex.store(tail + count, std::memory_order_release);
+        return count;
+    }
+
+    // Consumer side: drops everything written so far
+    void discard() {
+        readIndex.store(writeIndex.load(std::memory_order_acquire), std::memory_order_release);
+    }
+
+    // Items ready for the consumer; never overestimates when called on the consumer thread
+    size_t readAvailable() const {
+        return writeIndex.load(std::memory_order_acquire) - readIndex.load(std::memory_order_acquire);
+    }
+
+    // Free slots for the producer; never overestimates when called on the producer thread
+    size_t writeAvailable() const {
+        return capacity - readAvailable();
+    }
+
+    // Empties the buffer; only valid while neither side is running
+    void reset() {
+        readIndex.store(0, std::memory_order_relaxed);
+        writeIndex.store(0, std::memory_order_relaxed);
+    }
+
+private:
+    std::unique_ptr<T[]> buffer;
+    size_t capacity;
+    size_t mask;
+
+    // Monotonic counters, wrapped with the mask on access. Kept on separate cache lines
+    // so the producer and consumer do not invalidate each other's index.
+    alignas(64) std::atomic<size_t> writeIndex{0};
+    alignas(64) std::atomic<size_t> readIndex{0};
+};
+
+#endif // SPSC_RING_BUFFER_H
@@ -0,0 +1,55 @@
+#ifndef TRACK_LOADER_H
+#define TRACK_LOADER_H
+
+#include <QObject>
+#include <QString>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "include/core/SpectrogramBuffer.h"
+#include "include/core/DecodedAudioCache.h"
+#include "include/core/WaveformOverview.h"
+
+// Loads a track on a background thread: decodes the PCM once (so playback can start early), builds
+// the waveform overview, then analyzes that same PCM, publishing spectrogram frames in chunks as they are computed.
+// All signals are delivered on the thread that owns the loader (the GUI thread).
+class TrackLoader : public QObject {
+    Q_OBJECT
+
+public:
+    explicit TrackLoader(QObject* parent = nullptr);
+    ~TrackLoader();
+
+    // Cancels a running load before starting the new one
+    void load(const QString& filePath, int sampleRate = 48000, int fftSize = 1024, int maxFrequency = 48000);
+    void cancel();
+    bool isLoading() const { return loading; }
+
+signals:
+    void pcmReady(std::shared_ptr<const DecodedAudio> audio);
+    void waveformReady(std::shared_ptr<const WaveformOverview> waveform);
+    void analysisStarted(int bins, qint64 expectedFrames, double duration);
+    // frameCount x bins raw (not yet normalized) magnitudes, plus the largest magnitude seen so far
+    void framesReady(qint64 firstFrame, std::shared_ptr<std::vector<float>> frames, int bins, float runningMax);
+    void progressChanged(int percent);
+    void spectrogramReady(std::shared_ptr<SpectrogramBuffer> spectrogram, double duration);
+    void loadFailed(const QString& message);      // No playable PCM
+    void analysisFailed(const QString& message);  // PCM is usable, but there is no spectrogram
+    void loadCancelled();
+
+private:
+    void run(quint64 generation, std::string filePath, int sampleRate, int fftSize, int maxFrequency);
+
+    // Runs fn on the owning thread, unless the load it belongs to has been superseded or cancelled
+    template <typename Fn>
+    void post(quint64 generation, Fn fn);
+
+    std::thread worker;
+    std::atomic<bool> cancelRequested{ false };
+    quint64 activeGeneration = 0; // Only touched on the owning thread
+    bool loading = false;
+};
+
+#endif // TRACK_LOADER_H
@@ -0,0 +1,56 @@
+#ifndef WAVEFORM_OVERVIEW_H
+#define WAVEFORM_OVERVIEW_H
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+class DecodedAudio;
+
+// One pixel column of the waveform lane
+struct WaveformColumn {
+    float min = 0.0f;
+    float max = 0.0f;
+    float rms = 0.0f;
+};
+
+// Min/max/energy pyramid over a decoded track. Level 0 summarizes blocks of kBaseBlock samples
+// (one vectorized pass over the PCM); every further level halves the resolution by merging pairs.
+// A query picks the level whose blocks are just narrower than a pixel, so each column touches at
+// most three blocks and the cost is O(width) however long the track is. Immutable once built,
+// so it can be shared with any thread.
+class WaveformOverview {
+public:
+    static constexpr size_t kBaseBlock = 64;
+
+    explicit WaveformOverview(std::shared_ptr<const DecodedAudio> audio);
+
+    size_t sampleCount() const;
+    int sampleRate() const;
+    double duration() const;
+    size_t levelCount() const { return levels.size(); }
+    size_t memoryBytes() const;
+
+    // width columns covering [startSample, endSample); columns outside the track stay zero
+    void query(double startSample, double endSample, WaveformColumn* out, size_t width) const;
+    std::vector<WaveformColumn> query(double startSample, double endSample, size_t width) const;
+
+    // Same, by time
+    std::vector<WaveformColumn> queryTime(double startSeconds, double endSeconds, size_t width) const;
+
+private:
+    struct Level {
+        size_t blockSize;
+        std::vector<float> mins;
+        std::vector<float> maxs;
+        std::vector<float> energies; // Sum of squares
+    };
+
+    WaveformColumn fromSamples(size_t begin, size_t end) const;
+    WaveformColumn fromLevel(const Level& level, size_t begin, size_t end) const;
+
+    std::shared_ptr<const DecodedAudio> audio; // Raw samples when zoomed in past the base level
+    std::vector<Level> levels;
+};
+
+#endif // WAVEFORM_OVERVIEW_H
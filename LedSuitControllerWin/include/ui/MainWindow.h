@@ -7,14 +7,17 @@
 #include <QTimer> // Include for QTimer
 #include <QPushButton>                  
 #include "include/ui/SpectrogramView.h"
+#include "include/ui/WaveformLane.h"
 #include "include/core/AudioPreprocessor.h"
 #include "include/ui/LedSuitPictogram.h"
 #include "include/ui/PresetManager.h"
 #include "include/core/WaypointCompressor.h"
 #include "include/core/TcpClient.h"
+#include "include/core/TrackLoader.h"
 
 
 class AudioPlayer;
+class QProgressBar;
 
 class MainWindow : public QMainWindow {
     Q_OBJECT
@@ -44,9 +47,13 @@ private:
     QWidget* centralContainer;       // Central widget container
                                      
     AudioPlayer* audioPlayer; // Pointer to the audio player
+    TrackLoader* trackLoader; // Decodes and analyzes tracks in the background
+    QProgressBar* loadProgressBar; // Analysis progress, shown in the status bar
+    QPushButton* cancelLoadButton;
     QTimer* updateTimer;      // Timer to sync cursor updates
     LedSuitPictogram* ledSuitPictogram; // Pointer to pictogram
     SpectrogramView* spectrogramView;   // Pointer to spectrogram view  
+    WaveformLane* waveformLane;         // Waveform of the range the spectrogram shows
     WaypointCompressor* waypointCompressor;                                        
                               
     PresetManager presetManager;                    // Manages the presets
@@ -61,7 +68,8 @@ private:
     void settings();
     void openFileExplorer();
     void loadTestData();             // Test data for the spectrogram
-    void loadMusicFile(const std::string& filePath); 
+    void loadMusicFile(const std::string& filePath); // Starts an asynchronous load
+    void setupTrackLoader();
     void applyPreset(const std::string& presetName);
     void setupPresets();
     void deletePreset(const std::string& presetName);
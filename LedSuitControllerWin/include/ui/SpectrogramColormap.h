@@ -0,0 +1,33 @@
+#ifndef SPECTROGRAMCOLORMAP_H
+#define SPECTROGRAMCOLORMAP_H
+
+#include <QRgb>
+#include <algorithm>
+
+// Precomputed colors for the spectrogram: one ARGB entry per 8-bit intensity, so drawing a pixel
+// is a table load instead of a QColor conversion. Classic reproduces the original HSV ramp
+// (blue through red, brightness rising with the amplitude) exactly.
+class SpectrogramColormap {
+public:
+    enum class Palette { Classic, Grayscale, Inferno, Viridis };
+    static constexpr int kPaletteCount = 4;
+    static constexpr int kSize = 256;
+
+    explicit SpectrogramColormap(Palette palette = Palette::Classic);
+
+    Palette palette() const { return current; }
+    const char* name() const { return name(current); }
+    static const char* name(Palette palette);
+
+    // Display-scaled amplitude in [0, 1]; values outside are clamped
+    QRgb operator()(float amplitude) const {
+        return table[std::clamp(static_cast<int>(amplitude * (kSize - 1)), 0, kSize - 1)];
+    }
+    const QRgb* data() const { return table; }
+
+private:
+    Palette current;
+    QRgb table[kSize];
+};
+
+#endif // SPECTROGRAMCOLORMAP_H
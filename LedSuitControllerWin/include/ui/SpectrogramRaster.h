@@ -0,0 +1,54 @@
+#ifndef SPECTROGRAMRASTER_H
+#define SPECTROGRAMRASTER_H
+
+#include "include/core/SpectrogramBuffer.h"
+#include "include/ui/SpectrogramColormap.h"
+#include <QRgb>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Horizontal geometry of one zoom. Pixels are counted from the start of the track, so pixel p shows
+// base column p * visibleColumns / width at every scroll position: a scrolled image is the old
+// image moved by whole pixels, and pieces drawn at different times line up exactly.
+struct SpectrogramZoom {
+    int visibleColumns = 1;
+    int width = 1;
+
+    int64_t columnAt(int64_t pixel) const { return pixel * visibleColumns / width; }
+    // First pixel that shows column (or a later one)
+    int64_t pixelAt(int64_t column) const { return (column * width + visibleColumns - 1) / visibleColumns; }
+    bool operator==(const SpectrogramZoom& other) const {
+        return visibleColumns == other.visibleColumns && width == other.width;
+    }
+};
+
+// Everything needed to draw the spectrogram at one zoom and image height: the pyramid level, the
+// bin behind every image row and the colors. Immutable once built, so render threads share it.
+class SpectrogramRaster {
+public:
+    SpectrogramRaster(std::shared_ptr<const SpectrogramBuffer> level, int levelShift, SpectrogramZoom zoom,
+                      int rows, int bins, const SpectrogramColormap& colormap);
+
+    const SpectrogramZoom& zoom() const { return geometry; }
+    int rows() const { return static_cast<int>(rowBins.size()); }
+    const SpectrogramBuffer* source() const { return level.get(); }
+    int levelShift() const { return shift; }
+    SpectrogramColormap::Palette palette() const { return colormap.palette(); }
+
+    // Pixels [firstPixel, firstPixel + count) of the zoom into count columns of an RGB32 image
+    // (pixels points at the first row, stride in pixels). Column by column, so every frame's bins are
+    // read from one contiguous row; each pixel is a table load. Level frames from availableFrames on
+    // are drawn black and never read (they may still be being written).
+    void draw(int64_t firstPixel, int count, QRgb* pixels, size_t stride, size_t availableFrames = SIZE_MAX) const;
+
+private:
+    std::shared_ptr<const SpectrogramBuffer> level;
+    int shift;                  // Base columns per level frame: 1 << shift
+    SpectrogramZoom geometry;
+    std::vector<int> rowBins;   // Top row first
+    SpectrogramColormap colormap;
+};
+
+#endif // SPECTROGRAMRASTER_H
@@ -0,0 +1,68 @@
+#ifndef SPECTROGRAMRENDERER_H
+#define SPECTROGRAMRENDERER_H
+
+#include "include/ui/SpectrogramRaster.h"
+#include "include/ui/SpectrogramTileCache.h"
+#include <QImage>
+#include <QObject>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+// One frame of the spectrogram view: which part of which raster, plus the time axis labels
+struct SpectrogramFrameRequest {
+    std::shared_ptr<const SpectrogramRaster> raster;
+    int64_t origin = 0;              // Zoom pixel at the left edge
+    int width = 0;                   // Whole image, the time axis included
+    int height = 0;
+    bool tiled = false;              // Finished spectrogram: compose cached tiles
+    uint64_t tileGeneration = 0;     // tiles().currentGeneration() when the request was made
+    size_t availableFrames = SIZE_MAX; // While loading: frames written so far, the rest is black
+    int startColumn = 0;             // Time axis
+    int visibleColumns = 1;
+    double secondsPerColumn = 0.0;
+};
+
+// Draws spectrogram frames on its own thread, so the GUI thread never waits for pixels. Requests
+// that arrive while a frame is being drawn replace each other; only the latest viewport is drawn
+// next. Frames are drawn into two alternating back buffers and handed over through frameReady(),
+// delivered on the GUI thread, where the view swaps them onto the scene.
+// A frame that only scrolls the previous one (same raster, size and loaded frames) starts as that
+// frame moved by the pixel delta; only the newly exposed columns are drawn. Tiled frames requested
+// before the tile cache was last cleared are dropped: the view requests a new frame after clearing.
+class SpectrogramRenderer : public QObject {
+    Q_OBJECT
+
+public:
+    explicit SpectrogramRenderer(QObject* parent = nullptr);
+    ~SpectrogramRenderer();
+
+    void render(SpectrogramFrameRequest request);
+    SpectrogramTileCache& tiles() { return tileCache; }
+
+signals:
+    void frameReady(QImage frame, double renderMilliseconds, int drawnColumns);
+
+private:
+    void run();
+    // Spectrogram columns [x, x + count) of the image; false if tiles were missing (drawn black)
+    bool drawColumns(const SpectrogramFrameRequest& request, QImage& image, int x, int count);
+    void drawTimeAxis(const SpectrogramFrameRequest& request, QImage& image);
+    bool canShift(const SpectrogramFrameRequest& request) const;
+
+    SpectrogramTileCache tileCache; // Outlives the render thread
+    std::mutex mutex;
+    std::condition_variable wake;
+    SpectrogramFrameRequest pending;
+    bool hasPending = false;
+    bool stopping = false;
+    QImage buffers[2];              // Render thread only
+    int backBuffer = 0;
+    SpectrogramFrameRequest shown;  // Request behind the other buffer, the last frame handed over
+    bool shownComplete = false;     // That frame had every tile; only then is it shifted
+    std::thread worker;
+};
+
+#endif // SPECTROGRAMRENDERER_H
@@ -0,0 +1,102 @@
+#ifndef SPECTROGRAMTILECACHE_H
+#define SPECTROGRAMTILECACHE_H
+
+#include "include/ui/SpectrogramRaster.h"
+#include <QImage>
+#include <QObject>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// Pre-rendered spectrogram tiles, kTileWidth screen pixels wide, keyed by the raster they were drawn
+// from (data, zoom, image height, colors) and tile index, so scrolling and returning to a zoom only
+// blits, and a tile of an older raster is never handed out for a newer one. Missing tiles are rendered on worker threads; the
+// least recently used tiles are dropped once the cache is over its memory budget.
+// Safe to use from any thread; tileReady() is delivered on the thread that created the cache.
+class SpectrogramTileCache : public QObject {
+    Q_OBJECT
+
+public:
+    static constexpr int kTileWidth = 256;
+
+    explicit SpectrogramTileCache(size_t budgetBytes = 96u << 20, QObject* parent = nullptr);
+    ~SpectrogramTileCache();
+
+    // Drops all tiles and discards tiles being rendered, to free the memory of rasters no longer shown
+    void clear();
+
+    // Tile covering pixels [tile * kTileWidth, (tile + 1) * kTileWidth) of the raster's zoom, or a
+    // null image if it is not rendered yet for this raster
+    QImage find(const SpectrogramRaster& raster, int64_t tile);
+
+    // Renders the listed tiles that are not cached, in order. Replaces the tiles still waiting from
+    // the previous request, so only what the latest view needs gets rendered. Ignored if the cache
+    // was cleared after requestGeneration was read from currentGeneration().
+    void request(std::shared_ptr<const SpectrogramRaster> raster, const std::vector<int64_t>& tiles,
+                 uint64_t requestGeneration);
+
+    uint64_t currentGeneration() const; // Changes with every clear()
+
+    size_t memoryBytes() const;
+    size_t tileCount() const;
+
+signals:
+    void tileReady(); // One or more tiles arrived since the last signal
+
+private:
+    struct Key {
+        const SpectrogramBuffer* source;
+        int levelShift;
+        int rows;
+        SpectrogramColormap::Palette palette;
+        SpectrogramZoom zoom;
+        int64_t tile;
+
+        Key(const SpectrogramRaster& raster, int64_t tile)
+            : source(raster.source()), levelShift(raster.levelShift()), rows(raster.rows()),
+              palette(raster.palette()), zoom(raster.zoom()), tile(tile) {}
+        bool operator==(const Key& other) const {
+            return source == other.source && levelShift == other.levelShift && rows == other.rows &&
+                   palette == other.palette && zoom == other.zoom && tile == other.tile;
+        }
+    };
+    struct KeyHash {
+        size_t operator()(const Key& key) const;
+    };
+    struct Entry {
+        QImage image;
+        std::list<Key>::iterator recent;
+        std::shared_ptr<const SpectrogramRaster> raster; // Keeps key.source from being reused by other data
+    };
+    struct Job {
+        std::shared_ptr<const SpectrogramRaster> raster;
+        Key key;
+    };
+
+    void run();
+    void insert(const Key& key, QImage image, std::shared_ptr<const SpectrogramRaster> raster); // Locked
+    static size_t bytesOf(const QImage& image);
+
+    const size_t budget;
+    mutable std::mutex mutex;
+    std::condition_variable wake;
+    std::unordered_map<Key, Entry, KeyHash> tiles;
+    std::list<Key> recentTiles;                 // Most recently used first
+    std::unordered_set<Key, KeyHash> rendering; // In flight on a worker
+    std::deque<Job> queue;
+    size_t bytes = 0;
+    uint64_t generation = 0;                    // Bumped by clear(); older renders are dropped
+    bool stopping = false;
+    std::atomic<bool> notifyPending{false};
+    std::vector<std::thread> workers;
+};
+
+#endif // SPECTROGRAMTILECACHE_H
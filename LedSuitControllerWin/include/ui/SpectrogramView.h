@@ -2,16 +2,26 @@
 #define SPECTROGRAMVIEW_H
 
 #include "include/core/SuitState.h"
+#include "include/core/SpectrogramBuffer.h"
+#include "include/core/SpectrogramPyramid.h"
+#include "include/ui/SpectrogramColormap.h"
+#include "include/ui/SpectrogramRaster.h"
 #include <QGraphicsView>
 #include <QGraphicsLineItem>
 #include <vector>
 #include <utility> // For std::pair
 #include <QGraphicsSceneMouseEvent>
+#include <QElapsedTimer>
+#include <QImage>
+#include <chrono>
 #include <memory>
                    
 
 class AudioPlayer;
 class QGraphicsItemGroup;
+class QGraphicsPathItem;
+class QGraphicsRectItem;
+class SpectrogramRenderer;
 
 class SpectrogramView : public QGraphicsView {
     Q_OBJECT
@@ -23,7 +33,11 @@ public:
     void connectAudioPlayer(AudioPlayer* player); // Connects the spectrogram view to the audio player
     void updateCursor(); // Updates the cursor position on the spectrogram
     
-    void loadSpectrogram(const std::vector<std::vector<float>>& data, int sampleRate, int maxFrequency, float audioDuration); // Loads the spectrogram data
+    void loadSpectrogram(std::shared_ptr<SpectrogramBuffer> data, int sampleRate, int maxFrequency, float audioDuration); // Takes over the display-scaled spectrogram (time-major rows, no copy, never written)
+
+    // Progressive display while a track is still being analyzed; loadSpectrogram() replaces it with the final data
+    void beginProgressiveLoad(int bins, size_t expectedFrames, int sampleRate, int maxFrequency, float audioDuration);
+    void appendFrames(size_t firstFrame, const float* frames, size_t frameCount, float runningMax); // Raw magnitudes, frameCount x bins
 
     void setZoomLevel(float zoom); // Sets the zoom level of the spectrogram
     void scrollBy(int deltaX); // Scrolls the spectrogram horizontally
@@ -38,7 +52,21 @@ public:
     void clearWaypoints();
     void updateWaypointPositions(); // Updates waypoint positions during view changes
                                     
+    // Color table for the spectrogram; redraws when it changes
+    void setColormap(SpectrogramColormap::Palette palette);
+    SpectrogramColormap::Palette getColormap() const { return colormap.palette(); }
+
     float mapXToTime(float x) const;
+    float mapTimeToX(double seconds) const;
+
+    // Scroll continuously with the cursor in the middle of the view, instead of a page at a time
+    void setFollowPlayhead(bool enabled);
+    bool isFollowingPlayhead() const { return followPlayhead; }
+
+    // Snap added and dragged waypoints (and loop edges) to 1/subdivision of a beat of the player's grid
+    void setSnapToBeat(bool enabled, int subdivision = 1);
+    bool isSnappingToBeat() const { return snapToBeat; }
+    double snapTime(double seconds) const; // Unchanged while snapping is off or without a grid
     bool blockWaypointUpdates; 
 
                                     
@@ -47,35 +75,52 @@ public:
 signals:
     void waypointAdded(const Waypoint& waypoint);
     void updatePictograms(const std::vector<SuitState>& suitStates);
+    void visibleRangeChanged(double startSeconds, double endSeconds); // After every redraw
 
 public slots:
     void updateCursorFromAudio(double currentTime);
+    void showFrame(const QImage& frame, double renderMilliseconds, int drawnColumns); // From the render thread, via the event loop
+    void updateOverlays(); // Beat lines and loop region for the visible range, then the playhead
 
 
 protected:
-    void mousePressEvent(QMouseEvent* event) override;
+    void mousePressEvent(QMouseEvent* event) override;   // Starts scrubbing (or selects a waypoint)
+    void mouseMoveEvent(QMouseEvent* event) override;    // Scrubs while the left button is held
+    void mouseReleaseEvent(QMouseEvent* event) override; // Seeks to where scrubbing stopped
     void wheelEvent(QWheelEvent* event) override; // Handles mouse wheel events for zooming
     void resizeEvent(QResizeEvent* event) override; // Handles resize events for the view
-    void keyPressEvent(QKeyEvent* event) override;                                                    
-    void renderCursor(QImage &image, QPainter &painter);      
-    void updateCursorLayer();
+    void keyPressEvent(QKeyEvent* event) override; // Delete: remove waypoint, [ / ]: loop start / end at the cursor, L: clear loop
+    void updateCursorLayer(); // Moves the playhead line, once per cursor tick
 
 
 private:
     void updateView();
+    void updateRaster(const SpectrogramZoom& zoom, int rows); // Rebuilds raster when the zoom, height or colors change
+    int columnAtX(int x) const;
      
-    std::vector<std::vector<float>> downsampleSpectrogram(const std::vector<std::vector<float>>& data, int targetTimeFrames, int targetFrequencyBins); // Downsamples the spectrogram for efficient rendering
     std::vector<std::shared_ptr<Waypoint>> waypoints;
     std::shared_ptr<Waypoint> lastEmittedWaypoint = nullptr;
+    uint64_t seenLoopWraps = 0; // A new wrap re-triggers the waypoint state at the loop start
     std::vector<QGraphicsLineItem*> waypointItems;  // Graphics items representing waypoints
 
     QGraphicsScene* scene; // Graphics scene for rendering
     QGraphicsPixmapItem *spectrogramItem = nullptr; // Layer for spectrogram rendering
-    QGraphicsPixmapItem *cursorItem = nullptr;
+    QGraphicsPathItem* beatItem = nullptr;      // Beat lines
+    QGraphicsPathItem* downbeatItem = nullptr;  // Bar lines, brighter
+    QGraphicsRectItem* loopItem = nullptr;      // Loop region shading
+    QGraphicsPathItem* loopEdgesItem = nullptr;
+    QGraphicsLineItem* playheadItem = nullptr;  // Moved with setPos, never redrawn per tick
     QGraphicsItemGroup* waypointLayer = nullptr; // Dedicated layer for waypoints
                                                  //
     AudioPlayer* audioPlayer; // Pointer to the connected audio player
-    std::vector<std::vector<float>> spectrogramData; // Spectrogram data
+    std::shared_ptr<SpectrogramBuffer> spectrogram; // Spectrogram data, shared with the preprocessor
+    SpectrogramPyramid pyramid; // Time-axis mip levels of spectrogram for zoomed-out rendering
+    SpectrogramColormap colormap; // Intensity -> ARGB table used by updateView
+    std::shared_ptr<const SpectrogramRaster> raster; // Current zoom, height and colors, shared with the render threads
+    SpectrogramRenderer* renderer = nullptr; // Draws frames off the GUI thread, owns the tile cache
+    size_t loadedFrames = 0; // Progressive load: frames written so far
+    std::chrono::high_resolution_clock::time_point frameRequested; // For the Total Update line
+    double guiMilliseconds = 0.0;
     int sampleRate; // Sample rate of the audio
     int maxFrequency; // Maximum frequency of the spectrogramData
 
@@ -84,6 +129,14 @@ private:
     int currentOffset; // Current horizontal offset for rendering
     float duration; // Total duration of the audio in seconds
     bool autoScroll; // Whether auto-scrolling is enable
+    bool scrubbing = false; // Left button held on the spectrogram, the player plays grains
+    bool followPlayhead = false;
+    bool snapToBeat = false;
+    int snapSubdivision = 1;
+    int cursorTicks = 0; // Cursor tick cost, printed every 1000 ticks
+    double cursorTickTotal = 0.0;
+    double cursorTickMax = 0.0;
+    QElapsedTimer progressiveRedrawTimer; // Throttles redraws while frames are streaming in
 };
 
 
@@ -0,0 +1,38 @@
+#ifndef WAVEFORMLANE_H
+#define WAVEFORMLANE_H
+
+#include "include/core/WaveformOverview.h"
+#include <QWidget>
+#include <memory>
+#include <vector>
+
+// Waveform strip under the spectrogram: min/max outline with the RMS band on top, for the same
+// time range the spectrogram shows. Columns are queried from the overview pyramid on each resize
+// or range change, never from the raw PCM.
+class WaveformLane : public QWidget {
+    Q_OBJECT
+
+public:
+    explicit WaveformLane(QWidget* parent = nullptr);
+
+    void setOverview(std::shared_ptr<const WaveformOverview> overview);
+
+public slots:
+    void setVisibleRange(double startSeconds, double endSeconds);
+    void setCursorTime(double seconds);
+
+protected:
+    void paintEvent(QPaintEvent* event) override;
+    void resizeEvent(QResizeEvent* event) override;
+
+private:
+    void refreshColumns();
+
+    std::shared_ptr<const WaveformOverview> overview;
+    std::vector<WaveformColumn> columns; // One per pixel
+    double startSeconds = 0.0;
+    double endSeconds = 0.0;
+    double cursorSeconds = 0.0;
+};
+
+#endif // WAVEFORMLANE_H
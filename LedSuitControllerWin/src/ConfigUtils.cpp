@@ -31,6 +31,7 @@ static bool writeJsonToFile(const QString& filePath, const QJsonDocument& jsonDo
 static void createDefaultAppConfig(const QString& configFilePath) {
     QJsonObject defaultConfig;
     defaultConfig["numSuits"] = ::DefaultNumSuits; // Use fully qualified name
+    defaultConfig["fftwPlanner"] = "measure";       // Or "patient"
 
     if (writeJsonToFile(configFilePath, QJsonDocument(defaultConfig))) {
         qDebug() << "Created default appconfig.json at:" << configFilePath;
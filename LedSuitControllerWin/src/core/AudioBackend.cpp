@@ -0,0 +1,40 @@
+#include "include/core/AudioBackend.h"
+#include "include/core/NullAudioBackend.h"
+#include "include/core/PortAudioBackend.h"
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+std::unique_ptr<AudioBackend> AudioBackend::fromEnvironment() {
+    const char* value = std::getenv("LEDSUIT_AUDIO_BACKEND");
+    std::string spec = value ? value : "";
+
+    // "<kind>[:<argument>][:<speed>]"
+    std::string kind = spec.substr(0, spec.find(':'));
+    std::string rest = spec.size() > kind.size() ? spec.substr(kind.size() + 1) : std::string();
+
+    auto parseSpeed = [](const std::string& text) {
+        return text.empty() ? 0.0 : std::atof(text.c_str());
+    };
+
+    if (kind == "null") {
+        std::cout << "Audio backend: null, " << (rest.empty() ? std::string("as fast as possible") : rest + "x real time")
+                  << std::endl;
+        return std::make_unique<NullAudioBackend>(48000, parseSpeed(rest));
+    }
+    if (kind == "offline") {
+        std::string path = rest;
+        std::string speed;
+        size_t split = rest.rfind(':');
+        if (split != std::string::npos && split > 1) { // Keep "C:\..." intact
+            path = rest.substr(0, split);
+            speed = rest.substr(split + 1);
+        }
+        std::cout << "Audio backend: offline, rendering to " << path << std::endl;
+        return std::make_unique<OfflineAudioBackend>(path, 48000, parseSpeed(speed));
+    }
+    if (!kind.empty() && kind != "portaudio") {
+        std::cerr << "Unknown LEDSUIT_AUDIO_BACKEND '" << spec << "', using PortAudio." << std::endl;
+    }
+    return std::make_unique<PortAudioBackend>();
+}
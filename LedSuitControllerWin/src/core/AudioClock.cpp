@@ -0,0 +1,81 @@
+#include "include/core/AudioClock.h"
+#include <algorithm>
+#include <chrono>
+
+double AudioClock::steadyNow() {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void AudioClock::publish(uint64_t position, uint64_t count, double dacTime) {
+    // Samples before a discontinuity were never part of this run, so the clock must not interpolate into them
+    if (position != expectedNext) {
+        segmentStart = position;
+    }
+    expectedNext = position + count;
+
+    Snapshot snapshot;
+    snapshot.position = position;
+    snapshot.count = count;
+    snapshot.segmentStart = segmentStart;
+    snapshot.dacTime = dacTime;
+    snapshot.running = true;
+    write(snapshot);
+}
+
+void AudioClock::hold(uint64_t position) {
+    expectedNext = position;
+    segmentStart = position;
+
+    Snapshot snapshot;
+    snapshot.position = position;
+    snapshot.count = 0;
+    snapshot.segmentStart = position;
+    snapshot.dacTime = 0.0;
+    snapshot.running = false;
+    write(snapshot);
+}
+
+double AudioClock::position() const {
+    Snapshot snapshot = read();
+    if (!snapshot.running) {
+        return static_cast<double>(snapshot.position);
+    }
+
+    // Extrapolate from the last buffer, but never past what was written or before the current run
+    double elapsed = timeSource() - snapshot.dacTime;
+    double interpolated = static_cast<double>(snapshot.position) + elapsed * rate;
+    return std::clamp(interpolated, static_cast<double>(snapshot.segmentStart),
+                      static_cast<double>(snapshot.position + snapshot.count));
+}
+
+void AudioClock::write(const Snapshot& snapshot) {
+    // Odd sequence while the fields change
+    uint32_t start = sequence.load(std::memory_order_relaxed);
+    sequence.store(start + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    publishedPosition.store(snapshot.position, std::memory_order_relaxed);
+    publishedCount.store(snapshot.count, std::memory_order_relaxed);
+    publishedSegmentStart.store(snapshot.segmentStart, std::memory_order_relaxed);
+    publishedDacTime.store(snapshot.dacTime, std::memory_order_relaxed);
+    publishedRunning.store(snapshot.running, std::memory_order_relaxed);
+
+    sequence.store(start + 2, std::memory_order_release);
+}
+
+AudioClock::Snapshot AudioClock::read() const {
+    Snapshot snapshot;
+    uint32_t before;
+    uint32_t after;
+    do {
+        before = sequence.load(std::memory_order_acquire);
+        snapshot.position = publishedPosition.load(std::memory_order_relaxed);
+        snapshot.count = publishedCount.load(std::memory_order_relaxed);
+        snapshot.segmentStart = publishedSegmentStart.load(std::memory_order_relaxed);
+        snapshot.dacTime = publishedDacTime.load(std::memory_order_relaxed);
+        snapshot.running = publishedRunning.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        after = sequence.load(std::memory_order_relaxed);
+    } while ((before & 1) != 0 || before != after);
+    return snapshot;
+}
@@ -1,8 +1,11 @@
 #include "include/core/AudioPlayer.h"
-#include "../../include/portaudio/portaudio.h"
+#include "include/core/DecodedAudioCache.h"
+#include "include/core/Metronome.h"
+#include "include/core/WaveformOverview.h"
+#include <algorithm>
+#include <cmath>
 #include <iostream>    // For debug messages
 #include <stdexcept>   // For exceptions
-#include "../../include/libsndfile/sndfile.h"   // For audio file handling
 #include <vector>      // For std::vector
 #include <string>
 #include <chrono>
@@ -10,122 +13,401 @@
 #include <QObject>
 #include <QTimer>
 
-AudioPlayer::AudioPlayer() : currentTime(0.0), totalDuration(0.0), isPlaying_(false) {
-    if (Pa_Initialize() != paNoError) {
-        throw std::runtime_error("Failed to initialize PortAudio.");
+namespace {
+
+constexpr size_t kRingSamples = 1 << 15;    // ~0.7 s at 48 kHz, the only PCM the stream holds
+constexpr size_t kFeedChunk = 4096;         // Samples the feeder moves per write
+constexpr auto kFeederIdle = std::chrono::milliseconds(2);
+constexpr float kRampStep = 1.0f / 256.0f;  // Pause/resume gain ramp, ~5 ms at 48 kHz
+constexpr double kPi = 3.14159265358979323846;
+
+} // namespace
+
+AudioPlayer::AudioPlayer(std::unique_ptr<AudioBackend> outputBackend)
+    : backend(outputBackend ? std::move(outputBackend) : AudioBackend::fromEnvironment()),
+      totalDuration(0.0), isPlaying_(false), playbackMonitor(new QTimer(this)), ring(kRingSamples),
+      wrapMarkers(kRingSamples / kMinLoopSamples + 1) {
+    // Tracks are resampled to the device rate while decoding, so the stream never needs converting
+    sampleRate = backend->preferredSampleRate();
+    clock.setSampleRate(sampleRate);
+    clock.setTimeSource([output = backend.get()]() { return output->now(); });
+    std::cout << "Output device (" << backend->name() << ") sample rate: " << sampleRate << " Hz." << std::endl;
+
+    metronome = std::make_unique<const Metronome>(sampleRate);
+
+    // Periodic Hann, scaled so that the kMaxGrains overlapping windows add up to one
+    for (size_t i = 0; i < kGrainLength; ++i) {
+        grainWindow[i] = static_cast<float>((0.5 - 0.5 * std::cos(2.0 * kPi * i / kGrainLength)) * 2.0 / kMaxGrains);
     }
+    for (Grain& grain : grains) {
+        grain.age = kGrainLength;
+    }
+
+    // One monitor for the whole session, only running while playing
+    connect(playbackMonitor, &QTimer::timeout, this, &AudioPlayer::checkPlayback);
+    ensureStream();
 }
 
 
 AudioPlayer::~AudioPlayer() {
-    if (audioStream) {
-        Pa_StopStream(audioStream);
-        Pa_CloseStream(audioStream);
+    backend->close();
+    stopFeeder();
+}
+
+
+bool AudioPlayer::ensureStream() {
+    if (backend->isOpen()) {
+        return true;
     }
-    Pa_Terminate();
+
+    // The stream runs (silent while paused) until the player is destroyed
+    if (!backend->open(sampleRate, 256, [this](float* out, unsigned long frames, double dacTime) {
+            return renderAudio(out, frames, dacTime);
+        })) {
+        return false;
+    }
+    std::cout << "Output stream running, latency: " << backend->outputLatency() * 1000.0 << " ms." << std::endl;
+    return true;
 }
 
 
 bool AudioPlayer::loadFile(const std::string& filepath) {
-    SF_INFO sfinfo = {};
-    SNDFILE* sndfile = sf_open(filepath.c_str(), SFM_READ, &sfinfo);
-    if (!sndfile) {
-        std::cerr << "Failed to open audio file: " << sf_strerror(sndfile) << std::endl;
+    // Decodes only on the first open of a track, afterwards the cached PCM is mapped
+    DecodedAudioCache cache;
+    std::shared_ptr<const DecodedAudio> decoded = cache.open(QString::fromStdString(filepath), sampleRate);
+    if (!decoded) {
         return false;
     }
+    setAudio(std::move(decoded));
+    std::cout << "Loaded file: " << filepath << ", Duration: " << totalDuration << " seconds." << std::endl;
+    return true;
+}
 
-    // Store total duration
-    totalDuration = static_cast<double>(sfinfo.frames) / sfinfo.samplerate;
 
-    // Adjust for stereo files
-    if (sfinfo.channels == 2) {
-        std::cerr << "Downmixing stereo to mono for playback." << std::endl;
-        std::vector<float> stereoBuffer(sfinfo.frames * sfinfo.channels);
-        sf_read_float(sndfile, stereoBuffer.data(), sfinfo.frames * sfinfo.channels);
+void AudioPlayer::setAudio(std::shared_ptr<const DecodedAudio> decoded) {
+    // Fade out, then let the callback drop the old track's samples through a seek to the start
+    scrubActive.store(false, std::memory_order_release);
+    resumeAfterScrub = false;
+    isPlaying_ = false;
+    transportPlaying.store(false, std::memory_order_release);
+    playbackMonitor->stop();
+    stopFeeder(); // The feeder must not write any more of the old track
+
+    audio = std::move(decoded);
+    waveform.reset(); // Belongs to the previous track
+    liveScrubWindow.store(nullptr, std::memory_order_release); // Grains in flight play out their copies
+    if (publishedScrubWindow) {
+        publishedScrubWindow->retiredAt = retire();
+        publishedScrubWindow = nullptr;
+    }
+    totalDuration = audio ? audio->duration() : 0.0;
+    trackSamples.store(audio ? audio->sampleCount() : 0, std::memory_order_release);
+    trackFinished.store(false);
+    loopStart.store(0);
+    loopEnd.store(0); // Loop regions and the beat grid belong to the old track
+    setBeatGrid(BeatGrid());
+    requestSeek(0);
+    startFeeder();
+
+    if (audio) {
+        if (audio->sampleRate() != sampleRate) {
+            std::cerr << "Decoded audio is at " << audio->sampleRate() << " Hz but the device runs at "
+                      << sampleRate << " Hz; playback speed will be off." << std::endl;
+        }
+        std::cout << "Waveform size: " << audio->sampleCount() << " samples." << std::endl;
+        std::cout << "Expected size: " << totalDuration * sampleRate << " samples." << std::endl;
+    }
+}
+
+
+
+
+void AudioPlayer::startFeeder() {
+    if (feederRunning.load() || !audio) {
+        return;
+    }
+    feederRunning.store(true, std::memory_order_release);
+    feeder = std::thread(&AudioPlayer::feedLoop, this);
+}
+
+void AudioPlayer::stopFeeder() {
+    feederRunning.store(false, std::memory_order_release);
+    if (feeder.joinable()) {
+        feeder.join();
+    }
+}
 
-        // Downmix to mono
-        waveform.resize(sfinfo.frames);
-        for (sf_count_t i = 0; i < sfinfo.frames; ++i) {
-            waveform[i] = (stereoBuffer[i * 2] + stereoBuffer[i * 2 + 1]) / 2.0f;
+void AudioPlayer::requestSeek(uint64_t target) {
+    seekTarget.store(target, std::memory_order_release);
+    seekGeneration.fetch_add(1, std::memory_order_acq_rel);
+
+    // Without a running callback there is nobody to handshake with; move the ring directly
+    if (!backend->isOpen()) {
+        bool feederWasRunning = feederRunning.load();
+        stopFeeder();
+        settlePendingSeek();
+        if (feederWasRunning) {
+            startFeeder();
         }
-    } else if (sfinfo.channels == 1) {
-        // Mono audio
-        waveform.resize(sfinfo.frames);
-        sf_read_float(sndfile, waveform.data(), sfinfo.frames);
-    } else {
-        std::cerr << "Unsupported number of channels: " << sfinfo.channels << std::endl;
-        sf_close(sndfile);
-        return false;
     }
+}
 
-    sf_close(sndfile);
-    std::cout << "Loaded file: " << filepath << ", Duration: " << totalDuration << " seconds." << std::endl;
-    std::cout << "Waveform size: " << waveform.size() << " samples." << std::endl;
-    std::cout << "Expected size: " << totalDuration * 48000 << " samples." << std::endl;
+void AudioPlayer::settlePendingSeek() {
+    // Only with the feeder and the stream stopped: nobody else touches the ring
+    uint64_t generation = seekGeneration.load(std::memory_order_acquire);
+    if (generation != consumerGeneration.load(std::memory_order_acquire)) {
+        ring.reset();
+        wrapMarkers.reset();
+        streamRead = 0;
+        haveNextWrap = false;
+        feedPosition = seekTarget.load(std::memory_order_acquire);
+        playPosition.store(feedPosition, std::memory_order_release);
+        consumerGeneration.store(generation, std::memory_order_release);
+        clock.hold(feedPosition);
+    }
+}
 
-    return true;
+void AudioPlayer::feedLoop() {
+    const float* samples = audio->samples();
+    const uint64_t sampleCount = audio->sampleCount();
+    uint64_t resumedGeneration = consumerGeneration.load(std::memory_order_acquire);
+    uint64_t streamWritten = 0; // Ring samples written since the last seek, for the wrap markers
+
+    while (feederRunning.load(std::memory_order_acquire)) {
+        // Seek in flight: stop writing until the callback has dropped the stale samples
+        uint64_t generation = seekGeneration.load(std::memory_order_acquire);
+        if (generation != consumerGeneration.load(std::memory_order_acquire)) {
+            feederParked.store(generation, std::memory_order_release);
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            continue;
+        }
+        if (generation != resumedGeneration) {
+            feedPosition = playPosition.load(std::memory_order_acquire); // The callback moved it to the target
+            streamWritten = 0;                                           // and emptied the ring
+            resumedGeneration = generation;
+        }
+
+        // Inside a loop region the track ends at the loop end, and then starts over at the loop start
+        uint64_t end = sampleCount;
+        const uint64_t regionStart = loopStart.load(std::memory_order_acquire);
+        const uint64_t regionEnd = loopEnd.load(std::memory_order_acquire);
+        const bool looping = regionEnd > regionStart && feedPosition < regionEnd;
+        if (looping) {
+            end = std::min(regionEnd, sampleCount);
+        }
+
+        // Reading the mapping here keeps page faults off the audio thread
+        uint64_t remaining = end - std::min(feedPosition, end);
+        size_t space = ring.writeAvailable();
+        size_t count = static_cast<size_t>(std::min<uint64_t>(std::min(space, kFeedChunk), remaining));
+        const bool wraps = looping && count == remaining;
+        if (count == 0 || (count < kFeedChunk && count < remaining) || (wraps && wrapMarkers.writeAvailable() == 0)) {
+            std::this_thread::sleep_for(kFeederIdle); // Ring full (or track done); the callback drains it
+            continue;
+        }
+
+        // The marker goes in first, so the callback knows about the wrap before it can reach it
+        if (wraps) {
+            WrapMarker marker = { streamWritten + count, regionStart };
+            wrapMarkers.write(&marker, 1);
+        }
+        size_t written = ring.write(samples + feedPosition, count);
+        feedPosition += written;
+        streamWritten += written;
+        if (wraps) {
+            feedPosition = regionStart;
+        }
+    }
 }
 
+bool AudioPlayer::renderAudio(float* out, unsigned long frames, double dacTime) {
+    // Acknowledged on return: objects replaced up to this epoch are not read by this or any later buffer
+    const uint64_t epoch = publishEpoch.load(std::memory_order_acquire);
+    const bool wantPlaying = transportPlaying.load(std::memory_order_acquire);
+
+    // Seek handshake: once the feeder has stopped writing old samples, keep a short tail of them
+    // to crossfade from and drop the rest. Until then the old samples keep playing.
+    bool seeked = false;
+    uint64_t generation = seekGeneration.load(std::memory_order_acquire);
+    if (generation != consumerGeneration.load(std::memory_order_relaxed) &&
+        feederParked.load(std::memory_order_acquire) == generation) {
+        fadeTailLength = gain > 0.0f ? ring.read(fadeTail, kCrossfadeSamples) : 0;
+        fadeTailPosition = 0;
+        fadeTailGain = gain;
+        gain = 0.0f; // The new position ramps in while the tail ramps out
+        ring.discard();
+        wrapMarkers.discard();
+        streamRead = 0;
+        haveNextWrap = false;
+        playPosition.store(seekTarget.load(std::memory_order_acquire), std::memory_order_release);
+        consumerGeneration.store(generation, std::memory_order_release);
+        seeked = true;
+    }
 
+    // Paused: only read what the fade-out still needs, so the position stops where the sound does
+    size_t wanted = frames;
+    if (!wantPlaying) {
+        wanted = std::min<size_t>(frames, static_cast<size_t>(std::ceil(gain / kRampStep)));
+    }
+    const uint64_t start = playPosition.load(std::memory_order_relaxed);
 
+    // Backends that are not real time can wait for the feeder instead of playing an underrun
+    if (!backend->isRealTime() && feederRunning.load(std::memory_order_relaxed)) {
+        uint64_t remaining = trackSamples.load(std::memory_order_relaxed) - std::min(start, trackSamples.load());
+        if (start < loopEnd.load(std::memory_order_relaxed)) {
+            remaining = wanted; // A loop never runs out
+        }
+        if (ring.readAvailable() < std::min<uint64_t>(wanted, remaining)) {
+            finishedEpoch.store(epoch, std::memory_order_release);
+            return false;
+        }
+    }
 
-void AudioPlayer::play() {
-    if (!isPlaying_) {
-
-        PaError err = Pa_OpenDefaultStream(
-            &audioStream,
-            0,                           // No input channels
-            1,                           // Single output channel (mono)
-            paFloat32,                   // 32-bit floating-point audio
-            48000,                       // Sample rate (48,000 Hz)
-            256,                         // Frames per buffer
-            [](const void*, void* outputBuffer, unsigned long framesPerBuffer,
-               const PaStreamCallbackTimeInfo*, PaStreamCallbackFlags, void* userData) -> int {
-                AudioPlayer* player = static_cast<AudioPlayer*>(userData);
-                float* out = static_cast<float*>(outputBuffer);
-
-                unsigned long samplesToProcess = framesPerBuffer;
-                if (player->currentTime + samplesToProcess > player->waveform.size()) {
-                    samplesToProcess = player->waveform.size() - player->currentTime;
-                }
+    size_t copied = ring.read(out, wanted);
+    std::fill(out + copied, out + frames, 0.0f);
+
+    // Follow the loop wraps the feeder wrote into these samples; the clock gets the part after the last one.
+    // The clicks go into each stretch of consecutive track samples, before the gain ramp so they fade too.
+    uint64_t position = start;
+    uint64_t segmentPosition = start;
+    size_t segmentOffset = 0;
+    size_t done = 0;
+    for (;;) {
+        if (!haveNextWrap) {
+            haveNextWrap = wrapMarkers.read(&nextWrap, 1) == 1;
+        }
+        if (!haveNextWrap || nextWrap.streamIndex > streamRead + (copied - done)) {
+            renderClicks(out + done, position, copied - done);
+            position += copied - done;
+            streamRead += copied - done;
+            break;
+        }
+        size_t step = static_cast<size_t>(nextWrap.streamIndex - streamRead);
+        renderClicks(out + done, position, step);
+        streamRead += step;
+        done += step;
+        position = nextWrap.target;
+        haveNextWrap = false;
+        loopWraps.fetch_add(1, std::memory_order_release);
+        segmentPosition = position;
+        segmentOffset = done;
+    }
+    playPosition.store(position, std::memory_order_release);
+    clock.publish(segmentPosition, copied - segmentOffset, dacTime + static_cast<double>(segmentOffset) / sampleRate);
+
+    // Pause/resume ramp, also the fade-in after a seek. It only advances over real samples,
+    // so audio that arrives late after a seek or an underrun still fades in.
+    const float target = wantPlaying ? 1.0f : 0.0f;
+    if (gain != 1.0f || !wantPlaying) {
+        for (size_t i = 0; i < copied; ++i) {
+            gain = gain < target ? std::min(target, gain + kRampStep) : std::max(target, gain - kRampStep);
+            out[i] *= gain;
+        }
+    }
 
-                for (unsigned long i = 0; i < samplesToProcess; ++i) {
-                    *out++ = player->waveform[player->currentTime++];
-                }
+    // Crossfade: the pre-seek tail fades out over the fade-in (over silence if the new samples are late)
+    for (size_t i = 0; i < frames && fadeTailPosition < fadeTailLength; ++i, ++fadeTailPosition) {
+        float weight = static_cast<float>(fadeTailLength - fadeTailPosition) / static_cast<float>(fadeTailLength + 1);
+        out[i] += fadeTail[fadeTailPosition] * fadeTailGain * weight;
+    }
+
+    if (wantPlaying && copied < wanted) {
+        if (position >= trackSamples.load(std::memory_order_relaxed)) {
+            trackFinished.store(true, std::memory_order_release);
+        } else if (!seeked) {
+            underruns.fetch_add(1, std::memory_order_relaxed); // Feeder fell behind
+            gain = 0.0f;                                       // Fade back in once samples arrive
+        }
+    }
+
+    renderScrub(out, frames);
+    finishedEpoch.store(epoch, std::memory_order_release);
+    return true;
+}
+
+void AudioPlayer::renderClicks(float* out, uint64_t position, size_t count) {
+    if (!metronomeEnabled.load(std::memory_order_relaxed)) {
+        return;
+    }
+    const BeatGrid* grid = liveBeatGrid.load(std::memory_order_acquire);
+    if (grid) {
+        metronome->mix(*grid, position, out, count, metronomeGain.load(std::memory_order_relaxed));
+    }
+}
+
+void AudioPlayer::renderScrub(float* out, unsigned long frames) {
+    const bool active = scrubActive.load(std::memory_order_acquire);
+    bool sounding = false;
+    for (const Grain& grain : grains) {
+        sounding = sounding || grain.age < kGrainLength;
+    }
+    if (!active && !sounding) {
+        return; // After the release the grains in flight play out, so the scrub ends on a fade
+    }
 
-                if (player->currentTime >= player->waveform.size()) {
-                    return paComplete;
+    for (unsigned long i = 0; i < frames; ++i) {
+        // Every hop a grain starts from the latest scrub window, in the slot that just finished
+        if (grainClock == 0) {
+            const ScrubWindow* window = active ? liveScrubWindow.load(std::memory_order_acquire) : nullptr;
+            if (window) {
+                for (Grain& grain : grains) {
+                    if (grain.age >= kGrainLength) {
+                        std::copy(window->samples, window->samples + kGrainLength, grain.samples);
+                        grain.age = 0;
+                        break;
+                    }
                 }
+            }
+            grainClock = kGrainHop;
+        }
+        --grainClock;
 
-                return paContinue;
-            },
-            this
-        );
+        float sum = 0.0f;
+        for (Grain& grain : grains) {
+            if (grain.age < kGrainLength) {
+                sum += grain.samples[grain.age] * grainWindow[grain.age];
+                ++grain.age;
+            }
+        }
+        out[i] += sum;
+    }
+}
 
-        if (err != paNoError) {
-            std::cerr << "Failed to open PortAudio stream: " << Pa_GetErrorText(err) << std::endl;
+void AudioPlayer::checkPlayback() {
+    uint64_t underrunCount = getUnderrunCount();
+    if (underrunCount != reportedUnderruns) {
+        std::cerr << "Audio underruns: " << underrunCount << std::endl;
+        reportedUnderruns = underrunCount;
+    }
+    uint64_t wraps = getLoopWrapCount();
+    if (wraps != reportedLoopWraps) {
+        reportedLoopWraps = wraps;
+        emit loopWrapped(static_cast<double>(getLoopStart()) / sampleRate);
+    }
+    if (trackFinished.exchange(false)) {
+        isPlaying_ = false;
+        transportPlaying.store(false, std::memory_order_release);
+        playbackMonitor->stop();
+        emit playbackFinished();
+    }
+}
+
+void AudioPlayer::play() {
+    if (!isPlaying_ && audio) {
+        if (!ensureStream()) {
             return;
         }
 
-        err = Pa_StartStream(audioStream);
-        if (err != paNoError) {
-            std::cerr << "Failed to start PortAudio stream: " << Pa_GetErrorText(err) << std::endl;
-            return;
+        // Playing a finished track starts it over
+        if (playPosition.load() >= trackSamples.load() &&
+            seekGeneration.load() == consumerGeneration.load()) {
+            requestSeek(0);
         }
+        trackFinished.store(false);
+        transportPlaying.store(true, std::memory_order_release);
 
         isPlaying_ = true;
         std::cout << "Playing audio..." << std::endl;
-
-        // Monitor playback and emit a signal when it finishes
-        QTimer* playbackMonitor = new QTimer(this);
-        connect(playbackMonitor, &QTimer::timeout, [this, playbackMonitor]() {
-            if (Pa_IsStreamActive(audioStream) == 0) {
-                playbackMonitor->stop();
-                playbackMonitor->deleteLater();
-                emit playbackFinished();
-            }
-        });
-
         playbackMonitor->start(100); // Check playback status every 100ms
     }
 }
@@ -136,62 +418,197 @@ void AudioPlayer::play() {
 
 
 void AudioPlayer::pause() {
-    if (isPlaying_ && audioStream) {
-        PaError err = Pa_StopStream(audioStream);
-        if (err != paNoError) {
-            std::cerr << "Failed to pause PortAudio stream: " << Pa_GetErrorText(err) << std::endl;
-            return;
-        }
+    if (isPlaying_) {
+        // The callback ramps the gain down and then holds the position; the ring keeps its samples
+        transportPlaying.store(false, std::memory_order_release);
+        playbackMonitor->stop();
         isPlaying_ = false;
         std::cout << "Paused audio." << std::endl;
     }
 }
 
 void AudioPlayer::stop() {
-    if (isPlaying_ || currentTime > 0) {
-        if (audioStream) {
-            Pa_StopStream(audioStream);
-            Pa_CloseStream(audioStream);
-            audioStream = nullptr;
-        }
-        isPlaying_ = false;
-        currentTime = 0.0; // Reset current time
-        std::cout << "Stopped audio and reset time." << std::endl;
-    }
+    transportPlaying.store(false, std::memory_order_release);
+    playbackMonitor->stop();
+    isPlaying_ = false;
+    trackFinished.store(false);
+    requestSeek(0); // Reset current time
+    std::cout << "Stopped audio and reset time." << std::endl;
 }
 
 
 
 void AudioPlayer::seek(double positionInSeconds) {
     if (positionInSeconds >= 0.0 && positionInSeconds <= totalDuration) {
-        currentTime = positionInSeconds * 48000; // Convert to samples
+        uint64_t target = std::min<uint64_t>(static_cast<uint64_t>(positionInSeconds * sampleRate), trackSamples.load());
+        requestSeek(target);
         emit playbackPositionChanged(positionInSeconds);
-        std::cout << "Seeked to: " << currentTime / 48000 << " seconds." << std::endl;
+        std::cout << "Seeked to: " << static_cast<double>(target) / sampleRate << " seconds." << std::endl;
     } else {
         throw std::out_of_range("Seek position is out of range.");
     }
 }
 
+void AudioPlayer::setLoopRegion(uint64_t startSample, uint64_t endSample) {
+    const uint64_t count = trackSamples.load();
+    endSample = std::min(endSample, count);
+    if (endSample > startSample && endSample - startSample < kMinLoopSamples) {
+        endSample = std::min(count, startSample + kMinLoopSamples);
+    }
+    if (endSample <= startSample || endSample - startSample < kMinLoopSamples) {
+        startSample = endSample = 0;
+    }
+    if (startSample == loopStart.load() && endSample == loopEnd.load()) {
+        return;
+    }
+
+    loopStart.store(startSample, std::memory_order_release);
+    loopEnd.store(endSample, std::memory_order_release);
+    if (endSample > 0) {
+        std::cout << "Loop region: " << static_cast<double>(startSample) / sampleRate << " s to "
+                  << static_cast<double>(endSample) / sampleRate << " s." << std::endl;
+    } else {
+        std::cout << "Loop region cleared." << std::endl;
+    }
+
+    // The ring holds audio the feeder wrote for the old region; refill it from where the callback is
+    if (audio) {
+        bool seekPending = seekGeneration.load() != consumerGeneration.load();
+        requestSeek(seekPending ? seekTarget.load() : playPosition.load());
+    }
+}
+
+void AudioPlayer::setBeatGrid(const BeatGrid& grid) {
+    beatGrid = grid;
+
+    // The callback may still be reading the grids replaced before; drop only those it is done with
+    retiredBeatGrids.erase(std::remove_if(retiredBeatGrids.begin(), retiredBeatGrids.end(),
+                                          [this](const RetiredBeatGrid& retired) { return callbackDone(retired.retiredAt); }),
+                           retiredBeatGrids.end());
+
+    std::unique_ptr<const BeatGrid> previous = std::move(publishedBeatGrid);
+    if (grid.isValid()) {
+        publishedBeatGrid = std::make_unique<const BeatGrid>(grid);
+        std::cout << "Beat grid: " << grid.bpm() << " BPM from " << grid.firstBeatSeconds() << " s, "
+                  << grid.beatsPerBar() << " beats per bar." << std::endl;
+    }
+    liveBeatGrid.store(publishedBeatGrid.get(), std::memory_order_release);
+    if (previous) {
+        retiredBeatGrids.push_back(RetiredBeatGrid{ std::move(previous), retire() });
+    }
+}
+
+void AudioPlayer::setMetronomeEnabled(bool enabled) {
+    metronomeEnabled.store(enabled, std::memory_order_relaxed);
+}
+
+void AudioPlayer::setMetronomeGain(float newGain) {
+    metronomeGain.store(std::max(0.0f, newGain), std::memory_order_relaxed);
+}
+
+uint64_t AudioPlayer::scrubSampleAt(double positionInSeconds) const {
+    double sample = std::max(0.0, positionInSeconds) * sampleRate;
+    return std::min(static_cast<uint64_t>(sample), trackSamples.load(std::memory_order_relaxed));
+}
+
+void AudioPlayer::beginScrub(double positionInSeconds) {
+    if (!audio || scrubActive.load() || !ensureStream()) {
+        return;
+    }
+    // The transport fades out under the first grains and comes back on release
+    resumeAfterScrub = isPlaying_;
+    if (isPlaying_) {
+        transportPlaying.store(false, std::memory_order_release);
+        playbackMonitor->stop();
+        isPlaying_ = false;
+    }
+    scrubTo(positionInSeconds);
+    scrubActive.store(true, std::memory_order_release);
+}
+
+void AudioPlayer::scrubTo(double positionInSeconds) {
+    if (!audio) {
+        return;
+    }
+    uint64_t target = scrubSampleAt(positionInSeconds);
+    scrubTarget.store(target, std::memory_order_release);
+
+    // Copy the next grains' samples out of the mapping here, so page faults stay off the audio thread
+    ScrubWindow* window = freeScrubWindow();
+    if (!window) {
+        return; // Moves faster than the callback runs; the next one gets through
+    }
+    const uint64_t count = audio->sampleCount();
+    const uint64_t lastStart = count > kGrainLength ? count - kGrainLength : 0;
+    const uint64_t start = std::min(target > kGrainLength / 2 ? target - kGrainLength / 2 : 0, lastStart);
+    const size_t available = static_cast<size_t>(std::min<uint64_t>(kGrainLength, count - start));
+    std::copy(audio->samples() + start, audio->samples() + start + available, window->samples);
+    std::fill(window->samples + available, window->samples + kGrainLength, 0.0f);
+
+    liveScrubWindow.store(window, std::memory_order_release);
+    if (publishedScrubWindow) {
+        publishedScrubWindow->retiredAt = retire();
+    }
+    publishedScrubWindow = window;
+}
+
+uint64_t AudioPlayer::retire() {
+    return publishEpoch.fetch_add(1, std::memory_order_acq_rel) + 1;
+}
+
+bool AudioPlayer::callbackDone(uint64_t epoch) const {
+    // The stream is opened once and only closed on destruction; without it nothing reads
+    return !backend->isOpen() || finishedEpoch.load(std::memory_order_acquire) >= epoch;
+}
+
+AudioPlayer::ScrubWindow* AudioPlayer::freeScrubWindow() {
+    for (ScrubWindow& window : scrubWindows) {
+        if (&window != publishedScrubWindow && callbackDone(window.retiredAt)) {
+            return &window;
+        }
+    }
+    return nullptr;
+}
+
+void AudioPlayer::endScrub() {
+    if (!scrubActive.exchange(false)) {
+        return;
+    }
+    seek(std::min(static_cast<double>(scrubTarget.load()) / sampleRate, totalDuration));
+    if (resumeAfterScrub) {
+        play();
+    }
+    resumeAfterScrub = false;
+}
+
 double AudioPlayer::getCurrentTime() const {
-    return currentTime / 48000;
+    if (scrubActive.load(std::memory_order_acquire)) {
+        return static_cast<double>(scrubTarget.load(std::memory_order_acquire)) / sampleRate;
+    }
+    // A pending seek already counts as the new position
+    if (seekGeneration.load(std::memory_order_acquire) != consumerGeneration.load(std::memory_order_acquire)) {
+        return static_cast<double>(seekTarget.load(std::memory_order_acquire)) / sampleRate;
+    }
+    return clock.seconds();
 }
 
 double AudioPlayer::getTotalDuration() const {
     return totalDuration;
 }
 
+void AudioPlayer::setWaveform(std::shared_ptr<const WaveformOverview> overview) {
+    waveform = std::move(overview);
+}
+
 std::vector<float> AudioPlayer::getWaveformData(size_t sampleCount) const {
-    // Stub: Generate dummy waveform data
-    std::vector<float> data(sampleCount, 0.0f);
+    if (!waveform) {
+        return {};
+    }
+    std::vector<WaveformColumn> columns = waveform->query(0.0, static_cast<double>(waveform->sampleCount()), sampleCount);
+    std::vector<float> data(sampleCount);
     for (size_t i = 0; i < sampleCount; ++i) {
-        data[i] = static_cast<float>(i % 100) / 100.0f;
+        data[i] = std::max(std::fabs(columns[i].min), std::fabs(columns[i].max));
     }
     return data;
 }
 
-void AudioPlayer::extractWaveformData() {
-    // Stub implementation (replace with actual waveform extraction logic)
-    waveform = getWaveformData(1000);
-    std::cout << "Waveform data extracted." << std::endl;
-}
-
@@ -1,132 +1,364 @@
 #include "include/core/AudioPreprocessor.h"
-#include "../../include/libsndfile/sndfile.h"   // For audio file handling
+#include "include/core/SimdKernels.h"
 #include "../../include/fftw3/fftw3.h"
 #include <cmath>
+#include <algorithm>
 #include <stdexcept>
 #include <iostream>
+#include <chrono>
 #include <qmath.h>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <map>
 
-AudioPreprocessor::AudioPreprocessor()
-    : duration(0), sampleRate(48000), fftSize(1024), hopSize(512) {}
+namespace {
 
-AudioPreprocessor::~AudioPreprocessor() {}
+// Analysis threads, started on first use and kept for the whole session, so a batch costs two
+// wake-ups instead of a thread spawn and join per worker. The calling thread takes tasks as well.
+class WorkerPool {
+public:
+    explicit WorkerPool(unsigned threadCount) {
+        for (unsigned i = 0; i < threadCount; ++i) {
+            threads.emplace_back(&WorkerPool::loop, this);
+        }
+    }
 
-bool AudioPreprocessor::loadFile(const std::string& filepath, int sampleRate, int fftSize) {
-    this->sampleRate = sampleRate;
-    this->fftSize = fftSize;
-    this->hopSize = fftSize / 2; // Default 50% overlap
+    ~WorkerPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (auto& thread : threads) {
+            thread.join();
+        }
+    }
 
-    SF_INFO sfinfo;
-    SNDFILE* sndfile = sf_open(filepath.c_str(), SFM_READ, &sfinfo);
-    if (!sndfile) {
-        std::cerr << "Failed to open audio file: " << sf_strerror(sndfile) << std::endl;
-        return false;
+    unsigned size() const { return static_cast<unsigned>(threads.size()) + 1; }
+
+    // Runs task(0) .. task(taskCount - 1) on the pool and returns when all of them are done.
+    // One batch at a time; concurrent callers wait for each other.
+    void run(unsigned taskCount, const std::function<void(unsigned)>& task) {
+        std::lock_guard<std::mutex> batchLock(batchMutex);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            current = &task;
+            nextTask = 0;
+            this->taskCount = taskCount;
+            unfinished = taskCount;
+        }
+        wake.notify_all();
+
+        std::unique_lock<std::mutex> lock(mutex);
+        runTasks(lock);
+        done.wait(lock, [this]() { return unfinished == 0; });
+        current = nullptr;
+    }
+
+private:
+    void loop() {
+        std::unique_lock<std::mutex> lock(mutex);
+        for (;;) {
+            wake.wait(lock, [this]() { return stopping || (current && nextTask < taskCount); });
+            if (stopping) {
+                return;
+            }
+            runTasks(lock);
+        }
+    }
+
+    void runTasks(std::unique_lock<std::mutex>& lock) {
+        while (current && nextTask < taskCount) {
+            const std::function<void(unsigned)>& task = *current;
+            unsigned index = nextTask++;
+            lock.unlock();
+            task(index);
+            lock.lock();
+            if (--unfinished == 0) {
+                done.notify_all();
+            }
+        }
+    }
+
+    std::mutex batchMutex;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+    const std::function<void(unsigned)>* current = nullptr;
+    unsigned nextTask = 0;
+    unsigned taskCount = 0;
+    unsigned unfinished = 0;
+    bool stopping = false;
+    std::vector<std::thread> threads;
+};
+
+WorkerPool& analysisPool() {
+    static WorkerPool pool(std::max(1u, std::thread::hardware_concurrency()) - 1);
+    return pool;
+}
+
+unsigned analysisWorkerCount() {
+    return analysisPool().size();
+}
+
+// Splits [0, count) into contiguous ranges and runs fn(begin, end, workerIndex) on the analysis pool,
+// one range per worker index
+template <typename Fn>
+void parallelFor(size_t count, unsigned workerCount, Fn fn) {
+    workerCount = static_cast<unsigned>(std::min<size_t>(workerCount, count));
+    if (workerCount <= 1) {
+        if (count > 0) {
+            fn(size_t(0), count, 0u);
+        }
+        return;
+    }
+
+    size_t chunk = (count + workerCount - 1) / workerCount;
+    unsigned ranges = static_cast<unsigned>((count + chunk - 1) / chunk);
+    analysisPool().run(ranges, [&](unsigned w) {
+        size_t begin = w * chunk;
+        fn(begin, std::min(count, begin + chunk), w);
+    });
+}
+
+// Frames handed to the worker pool at once; progress and cancellation are checked between batches
+constexpr size_t kAnalysisBatchFrames = 2048;
+
+// The FFTW planner is not thread-safe; plans are created once per fftSize and reused for the whole session
+std::mutex plannerMutex;
+std::map<int, fftwf_plan> planCache;
+std::string wisdomFilePath;
+AudioPreprocessor::PlannerRigor plannerRigor = AudioPreprocessor::PlannerRigor::Measure;
+
+fftwf_plan planForSize(int fftSize) {
+    std::lock_guard<std::mutex> lock(plannerMutex);
+    auto it = planCache.find(fftSize);
+    if (it != planCache.end()) {
+        return it->second;
     }
 
-    // Check if the audio is mono
-    if (sfinfo.channels != 1) {
-        std::cerr << "Only mono audio is supported for preprocessing. Channels: " << sfinfo.channels << std::endl;
-        sf_close(sndfile);
+    // Planning overwrites the arrays, so it runs on scratch buffers. fftwf_alloc_* gives the
+    // SIMD alignment that the new-array execute interface requires of every worker buffer too.
+    float* planInput = fftwf_alloc_real(fftSize);
+    fftwf_complex* planOutput = fftwf_alloc_complex(fftSize / 2 + 1);
+    unsigned flags = plannerRigor == AudioPreprocessor::PlannerRigor::Patient ? FFTW_PATIENT : FFTW_MEASURE;
+
+    auto start = std::chrono::high_resolution_clock::now();
+    fftwf_plan plan = fftwf_plan_dft_r2c_1d(fftSize, planInput, planOutput, flags);
+    auto end = std::chrono::high_resolution_clock::now();
+
+    fftwf_free(planInput);
+    fftwf_free(planOutput);
+    planCache[fftSize] = plan;
+
+    std::cout << "FFTW plan for fftSize " << fftSize << " ready after "
+              << std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count() << " ms" << std::endl;
+
+    // Persist whatever the planner learned so the next launch gets this plan for free
+    if (!wisdomFilePath.empty() && !fftwf_export_wisdom_to_filename(wisdomFilePath.c_str())) {
+        std::cerr << "Failed to save FFTW wisdom to " << wisdomFilePath << std::endl;
+    }
+    return plan;
+}
+
+} // namespace
+
+bool AudioPreprocessor::loadFftwWisdom(const std::string& filepath) {
+    std::lock_guard<std::mutex> lock(plannerMutex);
+    wisdomFilePath = filepath;
+    if (!fftwf_import_wisdom_from_filename(filepath.c_str())) {
+        std::cout << "No FFTW wisdom loaded from " << filepath << ", plans will be measured on first use." << std::endl;
         return false;
     }
+    std::cout << "Loaded FFTW wisdom from " << filepath << std::endl;
+    return true;
+}
+
+void AudioPreprocessor::setPlannerRigor(PlannerRigor rigor) {
+    std::lock_guard<std::mutex> lock(plannerMutex);
+    plannerRigor = rigor;
+}
 
-    // Read audio samples
-    audioSamples.resize(sfinfo.frames);
-    sf_read_float(sndfile, audioSamples.data(), sfinfo.frames);
-    sf_close(sndfile);
+AudioPreprocessor::AudioPreprocessor()
+    : duration(0), sampleRate(48000), fftSize(1024), hopSize(512) {}
+
+AudioPreprocessor::~AudioPreprocessor() {}
 
-    duration = static_cast<double>(sfinfo.frames) / sfinfo.samplerate;
+bool AudioPreprocessor::loadFile(const std::string& filepath, int sampleRate, int fftSize) {
+    // Shares one decode (and one mapping) with the player; downmixing and resampling happen there
+    DecodedAudioCache cache;
+    std::shared_ptr<const DecodedAudio> decoded = cache.open(QString::fromStdString(filepath), sampleRate, cancelFlag);
+    if (!decoded) {
+        std::cerr << "Failed to load audio file: " << filepath << std::endl;
+        return false;
+    }
+
+    setAudio(std::move(decoded), sampleRate, fftSize);
     std::cout << "Loaded file: " << filepath << ", Duration: " << duration << " seconds, Sample Rate: " << sampleRate << std::endl;
 
     return true;
 }
 
-void AudioPreprocessor::computeSpectrogram(int maxFrequency) {
-    size_t numFrames = (audioSamples.size() - fftSize) / hopSize + 1;
+void AudioPreprocessor::setAudio(std::shared_ptr<const DecodedAudio> decoded, int sampleRate, int fftSize) {
+    this->sampleRate = sampleRate;
+    this->fftSize = fftSize;
+    this->hopSize = fftSize / 2; // Default 50% overlap
+    audio = std::move(decoded);
+    duration = audio ? audio->duration() : 0.0;
+}
 
+void AudioPreprocessor::computeBinLayout(int sampleRate, int fftSize, int maxFrequency, int& maxBin, int& logBins) {
     // Map maxFrequency to the corresponding bin
-    int maxBin = static_cast<int>((maxFrequency / static_cast<float>(sampleRate / 2.0)) * (fftSize / 2));
+    maxBin = static_cast<int>((maxFrequency / static_cast<float>(sampleRate / 2.0)) * (fftSize / 2));
     maxBin = std::min(maxBin, fftSize / 2); // Ensure maxBin is within bounds
 
     // Define the number of bins for the logarithmic scale
-    int logBins = std::min(maxBin, 128); // Adjust as necessary for resolution
-    spectrogramData.resize(numFrames, std::vector<float>(logBins, 0.0f));
-
-    // Generate logarithmic scale indices
-    std::vector<int> logBinIndices(logBins + 1);
-    for (int i = 0; i <= logBins; ++i) {
-        logBinIndices[i] = static_cast<int>(
-            std::pow(10, i / static_cast<float>(logBins) * std::log10(maxBin + 1)) - 1
-        );
-        logBinIndices[i] = std::min(logBinIndices[i], maxBin);
-    }
+    logBins = std::min(maxBin, 128); // Adjust as necessary for resolution
+}
+
+std::string AudioPreprocessor::analysisSignature(int sampleRate, int fftSize, int maxFrequency) {
+    int layoutMaxBin = 0;
+    int layoutLogBins = 0;
+    computeBinLayout(sampleRate, fftSize, maxFrequency, layoutMaxBin, layoutLogBins);
+
+    auto bank = SpectrumFilterbank::logarithmic(fftSize, sampleRate, maxFrequency, layoutLogBins);
+
+    // Bump the layout tag whenever the windowing, transform or bin mapping changes
+    return "layout=hann-r2c-log10-display-v3"
+           ";sampleRate=" + std::to_string(sampleRate) +
+           ";fftSize=" + std::to_string(fftSize) +
+           ";hopSize=" + std::to_string(fftSize / 2) +
+           ";maxFrequency=" + std::to_string(maxFrequency) +
+           ";maxBin=" + std::to_string(layoutMaxBin) +
+           ";logBins=" + std::to_string(bank->bandCount()) +
+           ";bands=" + bank->signature();
+}
+
+void AudioPreprocessor::prepareAnalysis(int maxFrequency) {
+    computeBinLayout(sampleRate, fftSize, maxFrequency, maxBin, logBins);
 
-    std::vector<float> window(fftSize);
+    // Log bands are built once per parameter set and reused by every file and worker
+    filterbank = SpectrumFilterbank::logarithmic(fftSize, sampleRate, maxFrequency, logBins);
+    logBins = filterbank->bandCount();
+
+    window.resize(fftSize);
     for (size_t i = 0; i < fftSize; ++i) {
         window[i] = 0.5f * (1.0f - std::cos(2.0f * M_PI * i / (fftSize - 1))); // Hann window
     }
+}
 
-    fftwf_plan plan;
-    std::vector<float> inputBuffer(fftSize);
-    std::vector<float> outputBuffer(fftSize);
-    plan = fftwf_plan_r2r_1d(fftSize, inputBuffer.data(), outputBuffer.data(), FFTW_R2HC, FFTW_ESTIMATE);
+void AudioPreprocessor::applyWindow(const float* samples, float* inputBuffer) const {
+    simd::multiply(samples, window.data(), inputBuffer, fftSize);
+}
 
-    float maxMagnitude = 0.0f;
+float AudioPreprocessor::mapToLogBins(const float* fftOutput, float* linearSpectrum, double* bandScratch, float* frameBins) const {
+    // Compute the complex magnitude spectrum (fftOutput holds interleaved re/im pairs)
+    simd::complexMagnitude(fftOutput, linearSpectrum, maxBin + 1);
 
-    // First pass: Compute spectrogram and find max magnitude
-    for (size_t frameIdx = 0; frameIdx < numFrames; ++frameIdx) {
-        size_t startIdx = frameIdx * hopSize;
+    // Aggregate linear spectrum into logarithmic bins in a single pass
+    return filterbank->apply(linearSpectrum, frameBins, bandScratch);
+}
 
-        // Apply window function
-        for (size_t i = 0; i < fftSize; ++i) {
-            inputBuffer[i] = audioSamples[startIdx + i] * window[i];
-        }
+float AudioPreprocessor::analyzeFrames(const float* samples, size_t firstFrame, size_t frameCount) {
+    // One shared r2c plan; every worker executes it on its own arrays through the new-array interface
+    fftwf_plan plan = planForSize(fftSize);
 
-        // Perform FFT
-        fftwf_execute(plan);
+    unsigned workerCount = analysisWorkerCount();
+    std::vector<float> workerMax(workerCount, 0.0f);
 
-        // Compute magnitude spectrum and map to logarithmic bins
+    parallelFor(frameCount, workerCount, [&](size_t begin, size_t end, unsigned worker) {
+        // Per-worker buffers, allocated once per range instead of once per frame
+        float* inputBuffer = fftwf_alloc_real(fftSize);
+        fftwf_complex* outputBuffer = fftwf_alloc_complex(fftSize / 2 + 1);
         std::vector<float> linearSpectrum(maxBin + 1, 0.0f);
-        for (size_t i = 0; i <= maxBin; ++i) {
-            linearSpectrum[i] = std::sqrt(outputBuffer[i] * outputBuffer[i]);
+        std::vector<double> bandScratch(filterbank->scratchSize(), 0.0);
+        float localMax = 0.0f;
+
+        for (size_t frameIdx = begin; frameIdx < end; ++frameIdx) {
+            applyWindow(samples + frameIdx * hopSize, inputBuffer);
+            fftwf_execute_dft_r2c(plan, inputBuffer, outputBuffer);
+            float frameMax = mapToLogBins(reinterpret_cast<const float*>(outputBuffer), linearSpectrum.data(),
+                                          bandScratch.data(), spectrogram->row(firstFrame + frameIdx));
+            localMax = std::max(localMax, frameMax);
         }
 
-        // Aggregate linear spectrum into logarithmic bins
-        for (int i = 0; i < logBins; ++i) {
-            float sum = 0.0f;
-            int count = 0;
-            for (int j = logBinIndices[i]; j < logBinIndices[i + 1]; ++j) {
-                sum += linearSpectrum[j];
-                count++;
-            }
-            spectrogramData[frameIdx][i] = (count > 0) ? sum / count : 0.0f;
-            maxMagnitude = std::max(maxMagnitude, spectrogramData[frameIdx][i]);
+        workerMax[worker] = localMax;
+        fftwf_free(inputBuffer);
+        fftwf_free(outputBuffer);
+    });
+
+    return *std::max_element(workerMax.begin(), workerMax.end());
+}
+
+void AudioPreprocessor::normalizeSpectrogram(float maxMagnitude) {
+    // Normalize magnitudes logarithmically, then apply the display scaling in the same pass
+    float logMax = std::log10(1.0f + maxMagnitude);
+    if (logMax <= 0.0f) {
+        return; // Silent input, nothing to scale
+    }
+    parallelFor(spectrogram->frames(), analysisWorkerCount(), [&](size_t begin, size_t end, unsigned) {
+        for (size_t frameIdx = begin; frameIdx < end; ++frameIdx) {
+            simd::log10OnePlus(spectrogram->row(frameIdx), spectrogram->bins(), 1.0f / logMax);
+            applyDisplayScaling(spectrogram->row(frameIdx), spectrogram->bins());
         }
+    });
+}
+
+void AudioPreprocessor::applyDisplayScaling(float* row, size_t bins) {
+    // Logarithmic display scaling, maps [0.01, 10] onto [0, 1]
+    const float logFloor = std::log10(0.01f);
+    const float logRange = std::log10(10.0f) - logFloor;
+    simd::log10Remap(row, bins, 0.01f, logFloor, 1.0f / logRange);
+}
+
+bool AudioPreprocessor::computeSpectrogram(int maxFrequency, const FrameCallback& onFrame) {
+    if (!audio || audio->sampleCount() < static_cast<size_t>(fftSize)) {
+        std::cerr << "Not enough samples for a single FFT frame." << std::endl;
+        spectrogram.reset();
+        return false;
     }
+    size_t numFrames = (audio->sampleCount() - fftSize) / hopSize + 1;
 
-    // Second pass: Normalize magnitudes logarithmically
-    float logMax = std::log10(1.0f + maxMagnitude);
-    for (size_t frameIdx = 0; frameIdx < numFrames; ++frameIdx) {
-        for (size_t i = 0; i < logBins; ++i) {
-            float magnitude = spectrogramData[frameIdx][i];
-            spectrogramData[frameIdx][i] = std::log10(1.0f + magnitude) / logMax; // Normalize
+    prepareAnalysis(maxFrequency);
+    spectrogram = std::make_shared<SpectrogramBuffer>(numFrames, logBins);
+
+    // First pass: Compute spectrogram and find max magnitude (parallel max-reduction).
+    // The frames are read straight from the shared PCM, in batches so progress and cancellation get through.
+    float maxMagnitude = 0.0f;
+    for (size_t firstFrame = 0; firstFrame < numFrames; firstFrame += kAnalysisBatchFrames) {
+        if (cancelFlag && cancelFlag->load(std::memory_order_relaxed)) {
+            spectrogram.reset();
+            std::cout << "Spectrogram analysis cancelled." << std::endl;
+            return false;
+        }
+        size_t frameCount = std::min(kAnalysisBatchFrames, numFrames - firstFrame);
+        const float* batchSamples = audio->samples() + firstFrame * hopSize;
+        maxMagnitude = std::max(maxMagnitude, analyzeFrames(batchSamples, firstFrame, frameCount));
+
+        if (onFrame) {
+            for (size_t i = 0; i < frameCount; ++i) {
+                onFrame(firstFrame + i, spectrogram->row(firstFrame + i), logBins);
+            }
         }
     }
 
-    fftwf_destroy_plan(plan);
+    // Second pass: Normalize magnitudes logarithmically
+    normalizeSpectrogram(maxMagnitude);
+
     std::cout << "Spectrogram computed with " 
-              << spectrogramData.size() << " time frames and " 
-              << spectrogramData[0].size() << " frequency bins (logarithmic y-axis)." << std::endl;
+              << spectrogram->frames() << " time frames and " 
+              << spectrogram->bins() << " frequency bins (logarithmic y-axis)." << std::endl;
+    return true;
 }
 
-
-
-const std::vector<std::vector<float>>& AudioPreprocessor::getSpectrogram() const {
-    return spectrogramData;
+std::shared_ptr<SpectrogramBuffer> AudioPreprocessor::takeSpectrogram() {
+    return std::move(spectrogram);
 }
 
 size_t AudioPreprocessor::getFrameIndexForTime(double timeInSeconds) const {
-    return static_cast<size_t>((timeInSeconds / duration) * spectrogramData.size());
+    return static_cast<size_t>((timeInSeconds / duration) * getTimeFrames());
 }
 
 double AudioPreprocessor::getAudioDuration() const {
@@ -138,6 +370,5 @@ int AudioPreprocessor::getFrequencyBins() const {
 }
 
 int AudioPreprocessor::getTimeFrames() const {
-    return spectrogramData.size();
+    return spectrogram ? static_cast<int>(spectrogram->frames()) : 0;
 }
-
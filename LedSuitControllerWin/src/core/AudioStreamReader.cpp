@@ -0,0 +1,134 @@
+#include "include/core/AudioStreamReader.h"
+#include "include/core/SimdKernels.h"
+#include "../../include/libsndfile/sndfile.h"   // For audio file handling
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+namespace {
+
+constexpr sf_count_t kBlockFrames = 4096; // Small blocks: a jump decodes little past its target
+
+} // namespace
+
+AudioStreamReader::AudioStreamReader(const QString& audioFilePath, std::shared_ptr<const SeekIndex> seekIndex)
+    : index(std::move(seekIndex)) {
+    if (!index || index->empty()) {
+        std::cerr << "No seek index for " << audioFilePath.toStdString() << "; open it through the decoded audio cache first."
+                  << std::endl;
+        return;
+    }
+
+    SF_INFO sfinfo = {};
+    sndfile = sf_open(audioFilePath.toStdString().c_str(), SFM_READ, &sfinfo);
+    if (!sndfile) {
+        std::cerr << "Failed to open audio file: " << sf_strerror(sndfile) << std::endl;
+        return;
+    }
+    if (sfinfo.samplerate != index->sourceRate()) {
+        std::cerr << "Seek index does not belong to " << audioFilePath.toStdString() << std::endl;
+        sf_close(sndfile);
+        sndfile = nullptr;
+        return;
+    }
+
+    channels = sfinfo.channels;
+    block.resize(static_cast<size_t>(kBlockFrames) * channels);
+    mono.resize(static_cast<size_t>(kBlockFrames));
+    resampler = std::make_unique<PolyphaseResampler>(index->sourceRate(), index->outputRate());
+}
+
+AudioStreamReader::~AudioStreamReader() {
+    if (sndfile) {
+        sf_close(sndfile);
+    }
+}
+
+bool AudioStreamReader::seek(uint64_t outputSample) {
+    if (!sndfile) {
+        return false;
+    }
+    outputSample = std::min(outputSample, length());
+
+    // Constant time to the checkpoint, then at most one interval of decoding
+    SeekIndex::Point point = index->locate(outputSample);
+    if (sf_seek(sndfile, static_cast<sf_count_t>(point.sourceFrame), SEEK_SET) < 0) {
+        std::cerr << "Failed to seek in audio file: " << sf_strerror(sndfile) << std::endl;
+        rewind();
+        return false;
+    }
+    resampler->restart(point.sourceFrame, point.history);
+    pending.clear();
+    pendingOffset = 0;
+    finished = false;
+    outputPosition = point.outputSample;
+
+    while (outputPosition < outputSample) {
+        size_t available = pending.size() - pendingOffset;
+        if (available == 0) {
+            if (!decodeBlock()) {
+                break;
+            }
+            continue;
+        }
+        size_t skip = static_cast<size_t>(std::min<uint64_t>(available, outputSample - outputPosition));
+        pendingOffset += skip;
+        outputPosition += skip;
+    }
+    return true;
+}
+
+size_t AudioStreamReader::read(float* out, size_t count) {
+    if (!sndfile) {
+        return 0;
+    }
+    size_t written = 0;
+    while (written < count) {
+        size_t available = pending.size() - pendingOffset;
+        if (available == 0) {
+            if (!decodeBlock()) {
+                break;
+            }
+            continue;
+        }
+        size_t take = std::min(available, count - written);
+        std::memcpy(out + written, pending.data() + pendingOffset, take * sizeof(float));
+        pendingOffset += take;
+        written += take;
+    }
+    outputPosition += written;
+    return written;
+}
+
+bool AudioStreamReader::decodeBlock() {
+    if (finished) {
+        return false;
+    }
+    pending.erase(pending.begin(), pending.begin() + pendingOffset);
+    pendingOffset = 0;
+    const size_t before = pending.size();
+
+    // Same conversion stage as the decoded audio cache, so both produce the same samples
+    sf_count_t framesRead = sf_readf_float(sndfile, block.data(), kBlockFrames);
+    if (framesRead > 0) {
+        const float* monoBlock = block.data();
+        if (channels > 1) {
+            simd::downmix(block.data(), mono.data(), static_cast<size_t>(framesRead), channels);
+            monoBlock = mono.data();
+        }
+        resampler->process(monoBlock, static_cast<size_t>(framesRead), pending);
+    } else {
+        resampler->flush(pending);
+        finished = true;
+    }
+    return pending.size() > before || !finished;
+}
+
+void AudioStreamReader::rewind() {
+    sf_seek(sndfile, 0, SEEK_SET);
+    resampler = std::make_unique<PolyphaseResampler>(index->sourceRate(), index->outputRate());
+    pending.clear();
+    pendingOffset = 0;
+    outputPosition = 0;
+    finished = false;
+}
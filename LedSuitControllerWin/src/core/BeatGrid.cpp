@@ -0,0 +1,60 @@
+#include "include/core/BeatGrid.h"
+#include <algorithm>
+#include <cmath>
+
+BeatGrid::BeatGrid(double bpm, double firstBeatSeconds, int beatsPerBar, int sampleRate)
+    : tempo(bpm), barLength(std::max(1, beatsPerBar)), rate(sampleRate) {
+    if (bpm > 0.0 && sampleRate > 0) {
+        period = sampleRate * 60.0 / bpm;
+        firstBeat = std::llround(firstBeatSeconds * sampleRate);
+    }
+}
+
+double BeatGrid::firstBeatSeconds() const {
+    return rate > 0 ? static_cast<double>(firstBeat) / rate : 0.0;
+}
+
+int64_t BeatGrid::beatSample(int64_t beat) const {
+    return firstBeat + std::llround(static_cast<double>(beat) * period);
+}
+
+int64_t BeatGrid::beatAtOrBefore(int64_t sample) const {
+    if (!isValid()) {
+        return 0;
+    }
+    // The division can be off by one next to a rounded beat; the exact samples decide
+    int64_t beat = static_cast<int64_t>(std::floor(static_cast<double>(sample - firstBeat) / period));
+    while (beatSample(beat) > sample) {
+        --beat;
+    }
+    while (beatSample(beat + 1) <= sample) {
+        ++beat;
+    }
+    return beat;
+}
+
+bool BeatGrid::isDownbeat(int64_t beat) const {
+    return beat % barLength == 0;
+}
+
+int64_t BeatGrid::quantize(int64_t sample, int subdivision) const {
+    if (!isValid()) {
+        return sample;
+    }
+    subdivision = std::max(1, subdivision);
+    const int64_t beat = beatAtOrBefore(sample);
+    const int64_t from = beatSample(beat);
+    const int64_t span = beatSample(beat + 1) - from;
+
+    // Ticks inside the beat are rounded the same way as the beats, tick 0 and tick n are the beats
+    const double tick = static_cast<double>(span) / subdivision;
+    const int64_t index = std::llround(static_cast<double>(sample - from) / tick);
+    return from + std::llround(static_cast<double>(index) * tick);
+}
+
+double BeatGrid::quantizeTime(double seconds, int subdivision) const {
+    if (!isValid()) {
+        return seconds;
+    }
+    return static_cast<double>(quantize(std::llround(seconds * rate), subdivision)) / rate;
+}
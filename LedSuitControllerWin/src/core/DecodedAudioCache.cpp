@@ -0,0 +1,275 @@
+#include "include/core/DecodedAudioCache.h"
+#include "include/core/PolyphaseResampler.h"
+#include "include/core/SeekIndex.h"
+#include "include/core/SimdKernels.h"
+#include "../../include/libsndfile/sndfile.h"   // For audio file handling
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QSaveFile>
+#include <QDebug>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <vector>
+
+namespace {
+
+const char kMagic[8] = { 'L', 'S', 'C', 'P', 'C', 'M', 'F', '1' };
+const uint32_t kFormatVersion = 2; // 2: entries come with a seek index
+const char kDecoderVersion[] = "decoder=mono-f32-kaiser64-v2"; // Change whenever the decoded samples would differ
+
+// Fixed 64-byte header, followed by sampleCount mono float32 samples
+struct PcmHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t headerSize;
+    uint64_t sampleCount;
+    uint32_t sampleRate;
+    uint32_t sourceChannels;
+    uint8_t reserved[32];
+};
+static_assert(sizeof(PcmHeader) == 64, "PCM cache header must stay 64 bytes");
+
+// Tracks that are open somewhere in the process, keyed by content hash
+std::mutex registryMutex;
+std::map<QString, std::weak_ptr<const DecodedAudio>> openTracks;
+
+} // namespace
+
+DecodedAudio::DecodedAudio(const float* samples, size_t sampleCount, int sampleRate, QString contentHash,
+                           std::shared_ptr<void> keepAlive)
+    : sampleData(samples), count(sampleCount), rate(sampleRate), hash(std::move(contentHash)),
+      storage(std::move(keepAlive)) {}
+
+DecodedAudioCache::DecodedAudioCache(const QString& cacheDirectory)
+    : directory(cacheDirectory) {
+    QDir dir(directory);
+    if (!dir.exists() && !dir.mkpath(".")) {
+        qWarning() << "Failed to create decoded audio cache directory at:" << directory;
+    }
+}
+
+QString DecodedAudioCache::defaultDirectory() {
+    return QDir::currentPath() + "/cache/audio";
+}
+
+QString DecodedAudioCache::makeKey(const QString& audioFilePath, int sampleRate) {
+    QFile file(audioFilePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qWarning() << "Cannot hash audio file for the decoded audio cache:" << audioFilePath;
+        return QString();
+    }
+
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    if (!hash.addData(&file)) {
+        return QString();
+    }
+    hash.addData(QByteArray(kDecoderVersion));
+    hash.addData(QByteArray(";rate=") + QByteArray::number(sampleRate));
+    return QString::fromLatin1(hash.result().toHex());
+}
+
+QString DecodedAudioCache::entryPath(const QString& key) const {
+    return directory + "/" + key + ".pcm";
+}
+
+QString DecodedAudioCache::seekIndexPath(const QString& key) const {
+    return directory + "/" + key + ".seek";
+}
+
+std::shared_ptr<const SeekIndex> DecodedAudioCache::openSeekIndex(const QString& audioFilePath, int sampleRate) const {
+    QString key = makeKey(audioFilePath, sampleRate);
+    if (key.isEmpty()) {
+        return nullptr;
+    }
+    auto index = std::make_shared<SeekIndex>();
+    if (!index->load(seekIndexPath(key))) {
+        return nullptr;
+    }
+    return index;
+}
+
+std::shared_ptr<const DecodedAudio> DecodedAudioCache::open(const QString& audioFilePath, int sampleRate,
+                                                            const std::atomic<bool>* cancel) const {
+    QString key = makeKey(audioFilePath, sampleRate);
+    if (key.isEmpty()) {
+        return nullptr;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        auto it = openTracks.find(key);
+        if (it != openTracks.end()) {
+            if (auto audio = it->second.lock()) {
+                return audio; // Already mapped by another user
+            }
+            openTracks.erase(it);
+        }
+    }
+
+    std::shared_ptr<const DecodedAudio> audio = load(key);
+    if (audio) {
+        std::cout << "Decoded audio cache hit for " << audioFilePath.toStdString() << std::endl;
+    } else {
+        audio = decode(audioFilePath, key, sampleRate, cancel);
+    }
+
+    if (audio) {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        openTracks[key] = audio;
+    }
+    return audio;
+}
+
+std::shared_ptr<const DecodedAudio> DecodedAudioCache::load(const QString& key) const {
+    auto file = std::make_shared<QFile>(entryPath(key));
+    if (!file->open(QIODevice::ReadOnly)) {
+        return nullptr; // Miss
+    }
+
+    const qint64 fileSize = file->size();
+    if (fileSize < static_cast<qint64>(sizeof(PcmHeader))) {
+        qWarning() << "Ignoring truncated decoded audio cache entry:" << file->fileName();
+        return nullptr;
+    }
+
+    // Read-only mapping: every user of the track shares the same pages
+    uchar* mapped = file->map(0, fileSize);
+    if (!mapped) {
+        qWarning() << "Failed to map decoded audio cache entry:" << file->fileName();
+        return nullptr;
+    }
+
+    PcmHeader header;
+    std::memcpy(&header, mapped, sizeof(header));
+    if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 || header.version != kFormatVersion ||
+        header.headerSize != sizeof(PcmHeader) || header.sampleRate == 0 ||
+        static_cast<uint64_t>(fileSize) != sizeof(PcmHeader) + header.sampleCount * sizeof(float)) {
+        qWarning() << "Ignoring incompatible decoded audio cache entry:" << file->fileName();
+        return nullptr;
+    }
+
+    const float* samples = reinterpret_cast<const float*>(mapped + sizeof(PcmHeader));
+    return std::make_shared<DecodedAudio>(samples, static_cast<size_t>(header.sampleCount),
+                                          static_cast<int>(header.sampleRate), key, file);
+}
+
+std::shared_ptr<const DecodedAudio> DecodedAudioCache::decode(const QString& audioFilePath, const QString& key, int sampleRate,
+                                                              const std::atomic<bool>* cancel) const {
+    SF_INFO sfinfo = {};
+    SNDFILE* sndfile = sf_open(audioFilePath.toStdString().c_str(), SFM_READ, &sfinfo);
+    if (!sndfile) {
+        std::cerr << "Failed to open audio file: " << sf_strerror(sndfile) << std::endl;
+        return nullptr;
+    }
+    const int channels = sfinfo.channels;
+    const int outputRate = sampleRate > 0 ? sampleRate : sfinfo.samplerate;
+    PolyphaseResampler resampler(sfinfo.samplerate, outputRate);
+    SeekIndex seekIndex(sfinfo.samplerate, outputRate, resampler.downsampling(), resampler.historyLength());
+
+    // Decode straight into the cache file; only if that is impossible keep the PCM in memory
+    QSaveFile file(entryPath(key));
+    const bool writeToCache = file.open(QIODevice::WriteOnly);
+    std::shared_ptr<std::vector<float>> fallback;
+    if (!writeToCache) {
+        qWarning() << "Decoded audio cache is not writable, keeping PCM in memory:" << file.fileName();
+        fallback = std::make_shared<std::vector<float>>();
+        fallback->reserve(static_cast<size_t>(resampler.outputLength(static_cast<uint64_t>(sfinfo.frames))));
+    }
+
+    PcmHeader header = {};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kFormatVersion;
+    header.headerSize = sizeof(PcmHeader);
+    header.sampleRate = static_cast<uint32_t>(outputRate);
+    header.sourceChannels = static_cast<uint32_t>(channels);
+    if (writeToCache) {
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header)); // Sample count is patched in below
+    }
+
+    // Block-wise decode keeps memory flat and lets a cancel request through quickly
+    const sf_count_t blockFrames = 65536;
+    std::vector<float> block(static_cast<size_t>(blockFrames) * channels);
+    std::vector<float> mono(static_cast<size_t>(blockFrames));
+    std::vector<float> converted;
+    converted.reserve(static_cast<size_t>(resampler.outputLength(blockFrames)) + 64);
+    uint64_t sampleCount = 0;
+    bool ok = true;
+
+    // Hands converted samples to the cache file (or the in-memory fallback)
+    auto emitConverted = [&]() {
+        if (converted.empty()) {
+            return true;
+        }
+        if (writeToCache) {
+            const qint64 bytes = static_cast<qint64>(converted.size() * sizeof(float));
+            if (file.write(reinterpret_cast<const char*>(converted.data()), bytes) != bytes) {
+                qWarning() << "Failed to write decoded audio cache entry:" << file.fileName();
+                return false;
+            }
+        } else {
+            fallback->insert(fallback->end(), converted.begin(), converted.end());
+        }
+        sampleCount += converted.size();
+        converted.clear();
+        return true;
+    };
+
+    sf_count_t framesRead;
+    while ((framesRead = sf_readf_float(sndfile, block.data(), blockFrames)) > 0) {
+        if (cancel && cancel->load(std::memory_order_relaxed)) {
+            ok = false;
+            break;
+        }
+
+        // Conversion stage: downmix to mono, then resample to the output rate
+        const float* monoBlock = block.data();
+        if (channels > 1) {
+            simd::downmix(block.data(), mono.data(), static_cast<size_t>(framesRead), channels);
+            monoBlock = mono.data();
+        }
+        resampler.process(monoBlock, static_cast<size_t>(framesRead), converted);
+        seekIndex.append(monoBlock, static_cast<size_t>(framesRead));
+
+        if (!emitConverted()) {
+            ok = false;
+            break;
+        }
+    }
+    sf_close(sndfile);
+
+    if (ok) {
+        resampler.flush(converted);
+        ok = emitConverted();
+    }
+    if (!ok) {
+        if (writeToCache) {
+            file.cancelWriting();
+        }
+        return nullptr;
+    }
+
+    std::cout << "Decoded " << audioFilePath.toStdString() << ": " << channels << " channel(s) at "
+              << sfinfo.samplerate << " Hz -> " << sampleCount << " mono samples at " << outputRate << " Hz." << std::endl;
+
+    if (!writeToCache) {
+        return std::make_shared<DecodedAudio>(fallback->data(), fallback->size(), outputRate, key, fallback);
+    }
+
+    // Written before the PCM is committed, so a finished entry normally has its index
+    seekIndex.finish(sampleCount);
+    if (!seekIndex.empty() && !seekIndex.save(seekIndexPath(key))) {
+        qWarning() << "Decoded audio cache entry has no seek index:" << file.fileName();
+    }
+
+    header.sampleCount = sampleCount;
+    if (!file.seek(0) || file.write(reinterpret_cast<const char*>(&header), sizeof(header)) != sizeof(header) ||
+        !file.commit()) {
+        qWarning() << "Failed to finish decoded audio cache entry:" << file.fileName();
+        return nullptr;
+    }
+    return load(key);
+}
@@ -0,0 +1,55 @@
+#include "include/core/Metronome.h"
+#include "include/core/SimdKernels.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+constexpr double kClickSeconds = 0.02;    // Decayed to -40 dB; well under a beat at any usable tempo
+constexpr double kAccentHz = 1760.0;
+constexpr double kBeatHz = 1320.0;
+constexpr double kDecaySeconds = 0.004;
+constexpr double kAttackSeconds = 0.0005; // Avoids a step at the onset
+constexpr double kPi = 3.14159265358979323846;
+
+void synthesizeClick(std::vector<float>& click, double frequency, double amplitude, int sampleRate) {
+    for (size_t i = 0; i < click.size(); ++i) {
+        double t = static_cast<double>(i) / sampleRate;
+        double envelope = std::min(1.0, t / kAttackSeconds) * std::exp(-t / kDecaySeconds);
+        click[i] = static_cast<float>(amplitude * envelope * std::sin(2.0 * kPi * frequency * t));
+    }
+}
+
+} // namespace
+
+Metronome::Metronome(int sampleRate) {
+    const size_t length = static_cast<size_t>(std::max(1.0, kClickSeconds * sampleRate));
+    accentClick.resize(length);
+    beatClick.resize(length);
+    synthesizeClick(accentClick, kAccentHz, 0.8, sampleRate);
+    synthesizeClick(beatClick, kBeatHz, 0.5, sampleRate);
+}
+
+void Metronome::mix(const BeatGrid& grid, uint64_t position, float* out, size_t count, float gain) const {
+    if (!grid.isValid() || count == 0) {
+        return;
+    }
+    const int64_t from = static_cast<int64_t>(position);
+    const int64_t to = from + static_cast<int64_t>(count);
+    const int64_t length = static_cast<int64_t>(clickLength());
+
+    // From the last beat whose click still sounds at the first sample, to the last beat in the run
+    for (int64_t beat = grid.beatAtOrBefore(from - length) + 1;; ++beat) {
+        const int64_t onset = grid.beatSample(beat);
+        if (onset >= to) {
+            break;
+        }
+        const int64_t begin = std::max(onset, from);
+        const int64_t end = std::min(onset + length, to);
+        if (onset < 0 || begin >= end) {
+            continue; // Beats before the track start are never heard
+        }
+        const std::vector<float>& click = grid.isDownbeat(beat) ? accentClick : beatClick;
+        simd::mixAdd(click.data() + (begin - onset), out + (begin - from), static_cast<size_t>(end - begin), gain);
+    }
+}
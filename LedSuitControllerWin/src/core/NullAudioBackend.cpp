@@ -0,0 +1,95 @@
+#include "include/core/NullAudioBackend.h"
+#include "../../include/libsndfile/sndfile.h"   // For the offline WAV output
+#include <chrono>
+#include <iostream>
+
+NullAudioBackend::NullAudioBackend(int sampleRate, double speed)
+    : rate(sampleRate), speed(speed) {}
+
+NullAudioBackend::~NullAudioBackend() {
+    NullAudioBackend::close();
+}
+
+bool NullAudioBackend::open(int sampleRate, unsigned long framesPerBuffer, RenderCallback render) {
+    if (running.load()) {
+        return true;
+    }
+    rate = sampleRate;
+    bufferFrames = framesPerBuffer;
+    renderCallback = std::move(render);
+    running.store(true);
+    worker = std::thread(&NullAudioBackend::run, this);
+    return true;
+}
+
+void NullAudioBackend::close() {
+    running.store(false);
+    if (worker.joinable()) {
+        worker.join();
+    }
+}
+
+double NullAudioBackend::now() const {
+    return static_cast<double>(renderedFrames.load(std::memory_order_acquire)) / rate;
+}
+
+void NullAudioBackend::run() {
+    std::vector<float> buffer(bufferFrames);
+    const auto start = std::chrono::steady_clock::now();
+
+    while (running.load(std::memory_order_acquire)) {
+        // The buffer is heard the moment the virtual clock reaches it; there is no device latency
+        const uint64_t frames = renderedFrames.load(std::memory_order_relaxed);
+        if (!renderCallback(buffer.data(), bufferFrames, static_cast<double>(frames) / rate)) {
+            std::this_thread::yield(); // The player's feeder is behind; time stands still until it catches up
+            continue;
+        }
+        deliver(buffer.data(), bufferFrames);
+        renderedFrames.store(frames + bufferFrames, std::memory_order_release);
+
+        if (speed > 0.0) {
+            double realSeconds = static_cast<double>(frames + bufferFrames) / rate / speed;
+            std::this_thread::sleep_until(start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                                      std::chrono::duration<double>(realSeconds)));
+        } else {
+            std::this_thread::yield(); // Keep other threads (feeder, UI) going on small machines
+        }
+    }
+}
+
+OfflineAudioBackend::OfflineAudioBackend(const std::string& wavPath, int sampleRate, double speed)
+    : NullAudioBackend(sampleRate, speed), wavPath(wavPath) {}
+
+OfflineAudioBackend::~OfflineAudioBackend() {
+    OfflineAudioBackend::close();
+}
+
+void OfflineAudioBackend::close() {
+    NullAudioBackend::close();
+    if (!written && !wavPath.empty() && !output.empty()) {
+        written = writeWav();
+    }
+}
+
+void OfflineAudioBackend::deliver(const float* buffer, unsigned long frames) {
+    output.insert(output.end(), buffer, buffer + frames);
+}
+
+bool OfflineAudioBackend::writeWav() const {
+    SF_INFO sfinfo = {};
+    sfinfo.samplerate = preferredSampleRate();
+    sfinfo.channels = 1;
+    sfinfo.format = SF_FORMAT_WAV | SF_FORMAT_FLOAT;
+
+    SNDFILE* sndfile = sf_open(wavPath.c_str(), SFM_WRITE, &sfinfo);
+    if (!sndfile) {
+        std::cerr << "Failed to open offline render output " << wavPath << ": " << sf_strerror(sndfile) << std::endl;
+        return false;
+    }
+    sf_count_t frames = static_cast<sf_count_t>(output.size());
+    bool ok = sf_writef_float(sndfile, output.data(), frames) == frames;
+    sf_close(sndfile);
+
+    std::cout << "Offline render: " << output.size() << " samples written to " << wavPath << std::endl;
+    return ok;
+}
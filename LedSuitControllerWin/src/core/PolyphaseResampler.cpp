@@ -0,0 +1,129 @@
+#include "include/core/PolyphaseResampler.h"
+#include "include/core/SimdKernels.h"
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+namespace {
+
+constexpr double kPi = 3.14159265358979323846;
+constexpr double kKaiserBeta = 8.0;   // ~80 dB stopband
+constexpr double kCutoffMargin = 0.94; // Passband edge relative to the lower Nyquist rate
+
+// Zeroth-order modified Bessel function of the first kind (power series)
+double besselI0(double x) {
+    double sum = 1.0;
+    double term = 1.0;
+    for (int k = 1; k < 50; ++k) {
+        term *= (x / (2.0 * k)) * (x / (2.0 * k));
+        sum += term;
+        if (term < sum * 1e-12) {
+            break;
+        }
+    }
+    return sum;
+}
+
+} // namespace
+
+PolyphaseResampler::PolyphaseResampler(int inputRate, int outputRate, int tapsPerPhase) {
+    const int divisor = std::gcd(inputRate, outputRate);
+    upFactor = outputRate / divisor;
+    downFactor = inputRate / divisor;
+    taps = std::max(4, tapsPerPhase + (tapsPerPhase & 1)); // Even, so the kernel is centered
+
+    const int halfTaps = taps / 2;
+    history.assign(halfTaps - 1, 0.0f); // Leading silence for the first outputs
+    historyStart = -(halfTaps - 1);
+
+    if (isPassthrough()) {
+        return;
+    }
+
+    // Windowed sinc in units of input samples, low-passed below the lower of the two Nyquist rates
+    const double cutoff = 0.5 * std::min(1.0, static_cast<double>(upFactor) / downFactor) * kCutoffMargin;
+    const double windowNorm = besselI0(kKaiserBeta);
+
+    coefficients.resize(static_cast<size_t>(upFactor) * taps);
+    for (int phase = 0; phase < upFactor; ++phase) {
+        float* row = coefficients.data() + static_cast<size_t>(phase) * taps;
+        const double fraction = static_cast<double>(phase) / upFactor;
+        double total = 0.0;
+
+        for (int k = 0; k < taps; ++k) {
+            // Distance between the output instant and input sample (i - halfTaps + 1 + k)
+            double tau = fraction + (halfTaps - 1) - k;
+            double x = tau / halfTaps;
+            double value = 0.0;
+            if (std::fabs(x) < 1.0) {
+                double arg = 2.0 * cutoff * tau;
+                double sinc = (arg == 0.0) ? 1.0 : std::sin(kPi * arg) / (kPi * arg);
+                double window = besselI0(kKaiserBeta * std::sqrt(1.0 - x * x)) / windowNorm;
+                value = 2.0 * cutoff * sinc * window;
+            }
+            row[k] = static_cast<float>(value);
+            total += value;
+        }
+
+        for (int k = 0; k < taps; ++k) {
+            row[k] = static_cast<float>(row[k] / total); // Unity DC gain for every phase
+        }
+    }
+}
+
+uint64_t PolyphaseResampler::outputLength(uint64_t inputCount) const {
+    return (inputCount * upFactor + downFactor - 1) / downFactor;
+}
+
+void PolyphaseResampler::process(const float* input, size_t count, std::vector<float>& output) {
+    inputConsumed += count;
+    if (isPassthrough()) {
+        output.insert(output.end(), input, input + count);
+        return;
+    }
+    history.insert(history.end(), input, input + count);
+    emitAvailable(output);
+}
+
+void PolyphaseResampler::flush(std::vector<float>& output) {
+    if (isPassthrough()) {
+        return;
+    }
+    history.insert(history.end(), taps / 2, 0.0f); // Trailing silence for the last outputs
+    emitAvailable(output);
+}
+
+void PolyphaseResampler::restart(uint64_t inputPosition, const float* previous) {
+    const int keep = historyLength();
+    history.assign(previous, previous + keep);
+    historyStart = static_cast<int64_t>(inputPosition) - keep;
+    inputConsumed = inputPosition;
+    nextOutput = outputLength(inputPosition);
+}
+
+void PolyphaseResampler::emitAvailable(std::vector<float>& output) {
+    const int halfTaps = taps / 2;
+    const uint64_t limit = outputLength(inputConsumed);
+    const int64_t historyEnd = historyStart + static_cast<int64_t>(history.size());
+
+    while (nextOutput < limit) {
+        const uint64_t position = nextOutput * downFactor;
+        const int64_t center = static_cast<int64_t>(position / upFactor);
+        const int phase = static_cast<int>(position % upFactor);
+        if (center + halfTaps >= historyEnd) {
+            break; // Needs input that has not arrived yet
+        }
+
+        const float* window = history.data() + (center - halfTaps + 1 - historyStart);
+        output.push_back(simd::dot(coefficients.data() + static_cast<size_t>(phase) * taps, window, taps));
+        ++nextOutput;
+    }
+
+    // Drop the input that no future output can reach
+    const int64_t firstNeeded = static_cast<int64_t>((nextOutput * downFactor) / upFactor) - halfTaps + 1;
+    const int64_t drop = std::min<int64_t>(firstNeeded - historyStart, static_cast<int64_t>(history.size()));
+    if (drop > 0) {
+        history.erase(history.begin(), history.begin() + drop);
+        historyStart += drop;
+    }
+}
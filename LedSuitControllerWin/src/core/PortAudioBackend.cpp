@@ -0,0 +1,93 @@
+#include "include/core/PortAudioBackend.h"
+#include "../../include/portaudio/portaudio.h"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <stdexcept>
+
+namespace {
+
+double steadySeconds() {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+} // namespace
+
+PortAudioBackend::PortAudioBackend() {
+    if (Pa_Initialize() != paNoError) {
+        throw std::runtime_error("Failed to initialize PortAudio.");
+    }
+
+    PaDeviceIndex device = Pa_GetDefaultOutputDevice();
+    const PaDeviceInfo* info = device != paNoDevice ? Pa_GetDeviceInfo(device) : nullptr;
+    if (info && info->defaultSampleRate > 0) {
+        deviceRate = static_cast<int>(info->defaultSampleRate + 0.5);
+    }
+}
+
+PortAudioBackend::~PortAudioBackend() {
+    close();
+    Pa_Terminate();
+}
+
+bool PortAudioBackend::open(int sampleRate, unsigned long framesPerBuffer, RenderCallback render) {
+    if (stream) {
+        return true;
+    }
+    renderCallback = std::move(render);
+
+    PaError err = Pa_OpenDefaultStream(
+        &stream,
+        0,                           // No input channels
+        1,                           // Single output channel (mono)
+        paFloat32,                   // 32-bit floating-point audio
+        sampleRate,
+        framesPerBuffer,
+        &PortAudioBackend::streamCallback,
+        this
+    );
+    if (err != paNoError) {
+        stream = nullptr;
+        std::cerr << "Failed to open PortAudio stream: " << Pa_GetErrorText(err) << std::endl;
+        return false;
+    }
+
+    const PaStreamInfo* streamInfo = Pa_GetStreamInfo(stream);
+    latency = streamInfo ? streamInfo->outputLatency : 0.0;
+
+    err = Pa_StartStream(stream);
+    if (err != paNoError) {
+        std::cerr << "Failed to start PortAudio stream: " << Pa_GetErrorText(err) << std::endl;
+        Pa_CloseStream(stream);
+        stream = nullptr;
+        return false;
+    }
+    return true;
+}
+
+void PortAudioBackend::close() {
+    if (stream) {
+        Pa_StopStream(stream);
+        Pa_CloseStream(stream);
+        stream = nullptr;
+    }
+}
+
+double PortAudioBackend::now() const {
+    return steadySeconds();
+}
+
+int PortAudioBackend::streamCallback(const void*, void* output, unsigned long frames,
+                                     const PaStreamCallbackTimeInfo* timeInfo, PaStreamCallbackFlags, void* userData) {
+    auto* backend = static_cast<PortAudioBackend*>(userData);
+
+    // Some host APIs leave the DAC time at zero; then estimate it from the stream latency
+    double untilDac = backend->latency;
+    if (timeInfo && timeInfo->outputBufferDacTime > 0.0) {
+        untilDac = std::max(0.0, timeInfo->outputBufferDacTime - timeInfo->currentTime);
+    }
+
+    // A real device cannot wait, so whatever the player rendered goes out
+    backend->renderCallback(static_cast<float*>(output), frames, steadySeconds() + untilDac);
+    return paContinue;
+}
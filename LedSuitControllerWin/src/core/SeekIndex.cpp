@@ -0,0 +1,156 @@
+#include "include/core/SeekIndex.h"
+#include <QFile>
+#include <QSaveFile>
+#include <QDebug>
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+const char kMagic[8] = { 'L', 'S', 'C', 'S', 'E', 'E', 'K', '1' };
+const uint32_t kFormatVersion = 1;
+constexpr double kIntervalSeconds = 0.5; // Worst case work after a jump: decoding this much of the source
+
+// Fixed 64-byte header, followed by the checkpoint frames, output samples and histories
+struct SeekIndexHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t headerSize;
+    uint32_t sourceRate;
+    uint32_t outputRate;
+    uint32_t historyLength;
+    uint32_t reserved0;
+    uint64_t interval;
+    uint64_t pointCount;
+    uint64_t sourceFrames;
+    uint64_t outputSamples;
+};
+static_assert(sizeof(SeekIndexHeader) == 64, "Seek index header must stay 64 bytes");
+
+} // namespace
+
+SeekIndex::SeekIndex(int sourceRate, int outputRate, int alignment, int historyLength)
+    : sourceRateHz(sourceRate), outputRateHz(outputRate), historySize(historyLength),
+      recent(static_cast<size_t>(historyLength), 0.0f) { // Silence before the first sample, as in the resampler
+    const uint64_t step = static_cast<uint64_t>(std::max(1, alignment));
+    const uint64_t wanted = static_cast<uint64_t>(sourceRate * kIntervalSeconds);
+    intervalFrames = std::max<uint64_t>(1, (wanted + step - 1) / step) * step;
+    outputInterval = intervalFrames * static_cast<uint64_t>(outputRate) / static_cast<uint64_t>(sourceRate);
+}
+
+void SeekIndex::append(const float* mono, size_t count) {
+    if (intervalFrames == 0) {
+        return;
+    }
+    const int64_t blockStart = static_cast<int64_t>(totalSourceFrames);
+    const uint64_t blockEnd = totalSourceFrames + count;
+    const size_t history = static_cast<size_t>(historySize);
+
+    // Checkpoints whose first frame is in this block; their history may reach back into the
+    // previous blocks (kept in recent, which covers blockStart - history .. blockStart - 1)
+    for (uint64_t frame = frames.size() * intervalFrames; frame < blockEnd; frame += intervalFrames) {
+        frames.push_back(frame);
+        outputs.push_back(frame / intervalFrames * outputInterval);
+        for (size_t j = 0; j < history; ++j) {
+            int64_t source = static_cast<int64_t>(frame) - static_cast<int64_t>(history - j);
+            histories.push_back(source >= blockStart ? mono[source - blockStart]
+                                                     : recent[static_cast<size_t>(source - (blockStart - static_cast<int64_t>(history)))]);
+        }
+    }
+
+    // Keep the tail for the next block's checkpoints
+    if (count >= history) {
+        std::copy(mono + count - history, mono + count, recent.begin());
+    } else {
+        std::copy(recent.begin() + count, recent.end(), recent.begin());
+        std::copy(mono, mono + count, recent.end() - count);
+    }
+    totalSourceFrames = blockEnd;
+}
+
+void SeekIndex::finish(uint64_t outputSamples) {
+    totalOutputSamples = outputSamples;
+    recent.clear();
+    recent.shrink_to_fit();
+}
+
+SeekIndex::Point SeekIndex::point(size_t index) const {
+    return Point{ frames[index], outputs[index], histories.data() + index * static_cast<size_t>(historySize) };
+}
+
+SeekIndex::Point SeekIndex::locate(uint64_t outputSample) const {
+    size_t index = outputInterval > 0 ? static_cast<size_t>(outputSample / outputInterval) : 0;
+    return point(std::min(index, frames.size() - 1));
+}
+
+bool SeekIndex::save(const QString& path) const {
+    SeekIndexHeader header = {};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kFormatVersion;
+    header.headerSize = sizeof(SeekIndexHeader);
+    header.sourceRate = static_cast<uint32_t>(sourceRateHz);
+    header.outputRate = static_cast<uint32_t>(outputRateHz);
+    header.historyLength = static_cast<uint32_t>(historySize);
+    header.interval = intervalFrames;
+    header.pointCount = frames.size();
+    header.sourceFrames = totalSourceFrames;
+    header.outputSamples = totalOutputSamples;
+
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "Failed to write seek index:" << path;
+        return false;
+    }
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(frames.data()), static_cast<qint64>(frames.size() * sizeof(uint64_t)));
+    file.write(reinterpret_cast<const char*>(outputs.data()), static_cast<qint64>(outputs.size() * sizeof(uint64_t)));
+    file.write(reinterpret_cast<const char*>(histories.data()), static_cast<qint64>(histories.size() * sizeof(float)));
+    return file.commit();
+}
+
+bool SeekIndex::load(const QString& path) {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    QByteArray data = file.readAll();
+    SeekIndexHeader header;
+    if (data.size() < static_cast<int>(sizeof(header))) {
+        return false;
+    }
+    std::memcpy(&header, data.constData(), sizeof(header));
+
+    // Bound the point count and history length by what the file can hold before multiplying, so a
+    // damaged header cannot wrap the expected size
+    const uint64_t availableBytes = static_cast<uint64_t>(data.size()) - sizeof(header);
+    const bool sizeFits = header.historyLength <= availableBytes / sizeof(float) &&
+                          header.pointCount <= availableBytes / (2 * sizeof(uint64_t) + header.historyLength * sizeof(float));
+    if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 || header.version != kFormatVersion ||
+        header.headerSize != sizeof(header) || header.sourceRate == 0 || header.interval == 0 ||
+        header.pointCount == 0 || !sizeFits ||
+        availableBytes != header.pointCount * (2 * sizeof(uint64_t) + header.historyLength * sizeof(float))) {
+        qWarning() << "Ignoring incompatible seek index:" << path;
+        return false;
+    }
+    const size_t count = static_cast<size_t>(header.pointCount);
+
+    sourceRateHz = static_cast<int>(header.sourceRate);
+    outputRateHz = static_cast<int>(header.outputRate);
+    historySize = static_cast<int>(header.historyLength);
+    intervalFrames = header.interval;
+    outputInterval = intervalFrames * header.outputRate / header.sourceRate;
+    totalSourceFrames = header.sourceFrames;
+    totalOutputSamples = header.outputSamples;
+
+    const char* cursor = data.constData() + sizeof(header);
+    frames.resize(count);
+    outputs.resize(count);
+    histories.resize(count * static_cast<size_t>(historySize));
+    std::memcpy(frames.data(), cursor, count * sizeof(uint64_t));
+    cursor += count * sizeof(uint64_t);
+    std::memcpy(outputs.data(), cursor, count * sizeof(uint64_t));
+    cursor += count * sizeof(uint64_t);
+    std::memcpy(histories.data(), cursor, histories.size() * sizeof(float));
+    recent.clear();
+    return true;
+}
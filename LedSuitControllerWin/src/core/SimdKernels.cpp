@@ -0,0 +1,680 @@
+#include "include/core/SimdKernels.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define SIMD_KERNELS_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+// MSVC compiles intrinsics for any target; GCC/Clang need the ISA enabled per function
+#if defined(SIMD_KERNELS_X86) && !defined(_MSC_VER)
+#define SIMD_TARGET_SSE41 __attribute__((target("sse4.1")))
+#define SIMD_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#else
+#define SIMD_TARGET_SSE41
+#define SIMD_TARGET_AVX2
+#endif
+
+namespace simd {
+namespace {
+
+constexpr float kLog10OfE = 0.43429448190325182765f;
+
+// ---------------------------------------------------------------------------------------------
+// Scalar reference
+// ---------------------------------------------------------------------------------------------
+
+void multiplyScalar(const float* a, const float* b, float* out, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        out[i] = a[i] * b[i];
+    }
+}
+
+void mixAddScalar(const float* in, float* out, size_t count, float gain) {
+    for (size_t i = 0; i < count; ++i) {
+        out[i] += in[i] * gain;
+    }
+}
+
+void complexMagnitudeScalar(const float* interleaved, float* out, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        float re = interleaved[2 * i];
+        float im = interleaved[2 * i + 1];
+        out[i] = std::sqrt(re * re + im * im);
+    }
+}
+
+float sumScalar(const float* data, size_t count) {
+    float total = 0.0f;
+    for (size_t i = 0; i < count; ++i) {
+        total += data[i];
+    }
+    return total;
+}
+
+void downmixScalar(const float* interleaved, float* out, size_t frames, int channels) {
+    const float scale = 1.0f / channels;
+    for (size_t i = 0; i < frames; ++i) {
+        float total = 0.0f;
+        for (int c = 0; c < channels; ++c) {
+            total += interleaved[i * channels + c];
+        }
+        out[i] = total * scale;
+    }
+}
+
+float dotScalar(const float* a, const float* b, size_t count) {
+    float total = 0.0f;
+    for (size_t i = 0; i < count; ++i) {
+        total += a[i] * b[i];
+    }
+    return total;
+}
+
+float maxScalar(const float* data, size_t count) {
+    float result = count > 0 ? data[0] : 0.0f;
+    for (size_t i = 1; i < count; ++i) {
+        result = std::max(result, data[i]);
+    }
+    return result;
+}
+
+void blockStatsScalar(const float* data, size_t count, size_t blockSize, float* mins, float* maxs, float* energies) {
+    for (size_t block = 0, start = 0; start < count; ++block, start += blockSize) {
+        size_t end = std::min(count, start + blockSize);
+        float low = data[start];
+        float high = data[start];
+        float energy = 0.0f;
+        for (size_t i = start; i < end; ++i) {
+            low = std::min(low, data[i]);
+            high = std::max(high, data[i]);
+            energy += data[i] * data[i];
+        }
+        mins[block] = low;
+        maxs[block] = high;
+        energies[block] = energy;
+    }
+}
+
+void log10OnePlusScalar(float* data, size_t count, float scale) {
+    for (size_t i = 0; i < count; ++i) {
+        data[i] = std::log10(1.0f + data[i]) * scale;
+    }
+}
+
+void log10RemapScalar(float* data, size_t count, float floor, float offset, float scale) {
+    for (size_t i = 0; i < count; ++i) {
+        data[i] = (std::log10(std::max(data[i], floor)) - offset) * scale;
+    }
+}
+
+#if defined(SIMD_KERNELS_X86)
+
+// Cephes logf polynomial (as popularized by sse_mathfun): natural log of positive normal floats
+constexpr float kLogP0 = 7.0376836292E-2f;
+constexpr float kLogP1 = -1.1514610310E-1f;
+constexpr float kLogP2 = 1.1676998740E-1f;
+constexpr float kLogP3 = -1.2420140846E-1f;
+constexpr float kLogP4 = 1.4249322787E-1f;
+constexpr float kLogP5 = -1.6668057665E-1f;
+constexpr float kLogP6 = 2.0000714765E-1f;
+constexpr float kLogP7 = -2.4999993993E-1f;
+constexpr float kLogP8 = 3.3333331174E-1f;
+constexpr float kLogQ1 = -2.12194440E-4f;
+constexpr float kLogQ2 = 0.693359375f;
+constexpr float kSqrtHalf = 0.707106781186547524f;
+
+// ---------------------------------------------------------------------------------------------
+// SSE4.1 (4 lanes)
+// ---------------------------------------------------------------------------------------------
+
+SIMD_TARGET_SSE41 inline float horizontalSum128(__m128 v) {
+    __m128 shuffled = _mm_movehdup_ps(v);
+    __m128 sums = _mm_add_ps(v, shuffled);
+    shuffled = _mm_movehl_ps(shuffled, sums);
+    return _mm_cvtss_f32(_mm_add_ss(sums, shuffled));
+}
+
+SIMD_TARGET_SSE41 inline float horizontalMax128(__m128 v) {
+    v = _mm_max_ps(v, _mm_movehl_ps(v, v));
+    v = _mm_max_ss(v, _mm_movehdup_ps(v));
+    return _mm_cvtss_f32(v);
+}
+
+SIMD_TARGET_SSE41 inline float horizontalMin128(__m128 v) {
+    v = _mm_min_ps(v, _mm_movehl_ps(v, v));
+    v = _mm_min_ss(v, _mm_movehdup_ps(v));
+    return _mm_cvtss_f32(v);
+}
+
+// Fast natural log for x > 0
+SIMD_TARGET_SSE41 inline __m128 log128(__m128 x) {
+    const __m128 one = _mm_set1_ps(1.0f);
+    x = _mm_max_ps(x, _mm_castsi128_ps(_mm_set1_epi32(0x00800000))); // Clamp to the smallest normal
+
+    __m128i exponentBits = _mm_srli_epi32(_mm_castps_si128(x), 23);
+    x = _mm_and_ps(x, _mm_castsi128_ps(_mm_set1_epi32(~0x7f800000)));
+    x = _mm_or_ps(x, _mm_set1_ps(0.5f)); // Mantissa in [0.5, 1)
+
+    __m128 e = _mm_cvtepi32_ps(_mm_sub_epi32(exponentBits, _mm_set1_epi32(0x7f)));
+    e = _mm_add_ps(e, one);
+
+    __m128 mask = _mm_cmplt_ps(x, _mm_set1_ps(kSqrtHalf));
+    __m128 tmp = _mm_and_ps(x, mask);
+    x = _mm_sub_ps(x, one);
+    e = _mm_sub_ps(e, _mm_and_ps(one, mask));
+    x = _mm_add_ps(x, tmp);
+
+    __m128 z = _mm_mul_ps(x, x);
+    __m128 y = _mm_set1_ps(kLogP0);
+    y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(kLogP1));
+    y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(kLogP2));
+    y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(kLogP3));
+    y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(kLogP4));
+    y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(kLogP5));
+    y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(kLogP6));
+    y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(kLogP7));
+    y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(kLogP8));
+    y = _mm_mul_ps(_mm_mul_ps(y, x), z);
+
+    y = _mm_add_ps(y, _mm_mul_ps(e, _mm_set1_ps(kLogQ1)));
+    y = _mm_sub_ps(y, _mm_mul_ps(z, _mm_set1_ps(0.5f)));
+    x = _mm_add_ps(x, y);
+    return _mm_add_ps(x, _mm_mul_ps(e, _mm_set1_ps(kLogQ2)));
+}
+
+SIMD_TARGET_SSE41 void multiplySse41(const float* a, const float* b, float* out, size_t count) {
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        _mm_storeu_ps(out + i, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+    }
+    multiplyScalar(a + i, b + i, out + i, count - i);
+}
+
+SIMD_TARGET_SSE41 void mixAddSse41(const float* in, float* out, size_t count, float gain) {
+    const __m128 gainV = _mm_set1_ps(gain);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        _mm_storeu_ps(out + i, _mm_add_ps(_mm_loadu_ps(out + i), _mm_mul_ps(_mm_loadu_ps(in + i), gainV)));
+    }
+    mixAddScalar(in + i, out + i, count - i, gain);
+}
+
+SIMD_TARGET_SSE41 void complexMagnitudeSse41(const float* interleaved, float* out, size_t count) {
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128 first = _mm_loadu_ps(interleaved + 2 * i);      // r0 i0 r1 i1
+        __m128 second = _mm_loadu_ps(interleaved + 2 * i + 4); // r2 i2 r3 i3
+        __m128 power = _mm_hadd_ps(_mm_mul_ps(first, first), _mm_mul_ps(second, second));
+        _mm_storeu_ps(out + i, _mm_sqrt_ps(power));
+    }
+    complexMagnitudeScalar(interleaved + 2 * i, out + i, count - i);
+}
+
+SIMD_TARGET_SSE41 float sumSse41(const float* data, size_t count) {
+    __m128 acc = _mm_setzero_ps();
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        acc = _mm_add_ps(acc, _mm_loadu_ps(data + i));
+    }
+    return horizontalSum128(acc) + sumScalar(data + i, count - i);
+}
+
+SIMD_TARGET_SSE41 void downmixSse41(const float* interleaved, float* out, size_t frames, int channels) {
+    const __m128 scale = _mm_set1_ps(1.0f / channels);
+    size_t i = 0;
+    if (channels == 2) {
+        for (; i + 4 <= frames; i += 4) {
+            __m128 first = _mm_loadu_ps(interleaved + 2 * i);      // l0 r0 l1 r1
+            __m128 second = _mm_loadu_ps(interleaved + 2 * i + 4); // l2 r2 l3 r3
+            _mm_storeu_ps(out + i, _mm_mul_ps(_mm_hadd_ps(first, second), scale));
+        }
+    } else {
+        // No gather before AVX2: assemble one channel of four frames per step
+        for (; i + 4 <= frames; i += 4) {
+            const float* frame = interleaved + i * channels;
+            __m128 acc = _mm_setzero_ps();
+            for (int c = 0; c < channels; ++c) {
+                acc = _mm_add_ps(acc, _mm_setr_ps(frame[c], frame[channels + c], frame[2 * channels + c], frame[3 * channels + c]));
+            }
+            _mm_storeu_ps(out + i, _mm_mul_ps(acc, scale));
+        }
+    }
+    downmixScalar(interleaved + i * channels, out + i, frames - i, channels);
+}
+
+SIMD_TARGET_SSE41 float dotSse41(const float* a, const float* b, size_t count) {
+    __m128 acc = _mm_setzero_ps();
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+    }
+    return horizontalSum128(acc) + dotScalar(a + i, b + i, count - i);
+}
+
+SIMD_TARGET_SSE41 float maxSse41(const float* data, size_t count) {
+    if (count < 4) {
+        return maxScalar(data, count);
+    }
+    __m128 acc = _mm_loadu_ps(data);
+    size_t i = 4;
+    for (; i + 4 <= count; i += 4) {
+        acc = _mm_max_ps(acc, _mm_loadu_ps(data + i));
+    }
+    float result = horizontalMax128(acc);
+    return i < count ? std::max(result, maxScalar(data + i, count - i)) : result;
+}
+
+SIMD_TARGET_SSE41 void blockStatsSse41(const float* data, size_t count, size_t blockSize, float* mins, float* maxs, float* energies) {
+    for (size_t block = 0, start = 0; start < count; ++block, start += blockSize) {
+        size_t length = std::min(blockSize, count - start);
+        const float* in = data + start;
+        if (length < 4) {
+            blockStatsScalar(in, length, length, mins + block, maxs + block, energies + block);
+            continue;
+        }
+        __m128 low = _mm_loadu_ps(in);
+        __m128 high = low;
+        __m128 energy = _mm_mul_ps(low, low);
+        size_t i = 4;
+        for (; i + 4 <= length; i += 4) {
+            __m128 v = _mm_loadu_ps(in + i);
+            low = _mm_min_ps(low, v);
+            high = _mm_max_ps(high, v);
+            energy = _mm_add_ps(energy, _mm_mul_ps(v, v));
+        }
+        mins[block] = horizontalMin128(low);
+        maxs[block] = horizontalMax128(high);
+        energies[block] = horizontalSum128(energy);
+        if (i < length) {
+            float tailMin, tailMax, tailEnergy;
+            blockStatsScalar(in + i, length - i, length - i, &tailMin, &tailMax, &tailEnergy);
+            mins[block] = std::min(mins[block], tailMin);
+            maxs[block] = std::max(maxs[block], tailMax);
+            energies[block] += tailEnergy;
+        }
+    }
+}
+
+SIMD_TARGET_SSE41 void log10OnePlusSse41(float* data, size_t count, float scale) {
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 factor = _mm_set1_ps(kLog10OfE * scale);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128 v = _mm_add_ps(one, _mm_loadu_ps(data + i));
+        _mm_storeu_ps(data + i, _mm_mul_ps(log128(v), factor));
+    }
+    log10OnePlusScalar(data + i, count - i, scale);
+}
+
+SIMD_TARGET_SSE41 void log10RemapSse41(float* data, size_t count, float floor, float offset, float scale) {
+    const __m128 floorV = _mm_set1_ps(floor);
+    const __m128 log10E = _mm_set1_ps(kLog10OfE);
+    const __m128 offsetV = _mm_set1_ps(offset);
+    const __m128 scaleV = _mm_set1_ps(scale);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128 v = _mm_max_ps(_mm_loadu_ps(data + i), floorV);
+        __m128 log10V = _mm_mul_ps(log128(v), log10E);
+        _mm_storeu_ps(data + i, _mm_mul_ps(_mm_sub_ps(log10V, offsetV), scaleV));
+    }
+    log10RemapScalar(data + i, count - i, floor, offset, scale);
+}
+
+// ---------------------------------------------------------------------------------------------
+// AVX2 + FMA (8 lanes)
+// ---------------------------------------------------------------------------------------------
+
+SIMD_TARGET_AVX2 inline float horizontalSum256(__m256 v) {
+    __m128 low = _mm256_castps256_ps128(v);
+    __m128 high = _mm256_extractf128_ps(v, 1);
+    __m128 sums = _mm_add_ps(low, high);
+    __m128 shuffled = _mm_movehdup_ps(sums);
+    sums = _mm_add_ps(sums, shuffled);
+    shuffled = _mm_movehl_ps(shuffled, sums);
+    return _mm_cvtss_f32(_mm_add_ss(sums, shuffled));
+}
+
+SIMD_TARGET_AVX2 inline float horizontalMax256(__m256 v) {
+    __m128 m = _mm_max_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+    m = _mm_max_ps(m, _mm_movehl_ps(m, m));
+    m = _mm_max_ss(m, _mm_movehdup_ps(m));
+    return _mm_cvtss_f32(m);
+}
+
+SIMD_TARGET_AVX2 inline float horizontalMin256(__m256 v) {
+    __m128 m = _mm_min_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+    m = _mm_min_ps(m, _mm_movehl_ps(m, m));
+    m = _mm_min_ss(m, _mm_movehdup_ps(m));
+    return _mm_cvtss_f32(m);
+}
+
+SIMD_TARGET_AVX2 inline __m256 log256(__m256 x) {
+    const __m256 one = _mm256_set1_ps(1.0f);
+    x = _mm256_max_ps(x, _mm256_castsi256_ps(_mm256_set1_epi32(0x00800000)));
+
+    __m256i exponentBits = _mm256_srli_epi32(_mm256_castps_si256(x), 23);
+    x = _mm256_and_ps(x, _mm256_castsi256_ps(_mm256_set1_epi32(~0x7f800000)));
+    x = _mm256_or_ps(x, _mm256_set1_ps(0.5f));
+
+    __m256 e = _mm256_cvtepi32_ps(_mm256_sub_epi32(exponentBits, _mm256_set1_epi32(0x7f)));
+    e = _mm256_add_ps(e, one);
+
+    __m256 mask = _mm256_cmp_ps(x, _mm256_set1_ps(kSqrtHalf), _CMP_LT_OS);
+    __m256 tmp = _mm256_and_ps(x, mask);
+    x = _mm256_sub_ps(x, one);
+    e = _mm256_sub_ps(e, _mm256_and_ps(one, mask));
+    x = _mm256_add_ps(x, tmp);
+
+    __m256 z = _mm256_mul_ps(x, x);
+    __m256 y = _mm256_set1_ps(kLogP0);
+    y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(kLogP1));
+    y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(kLogP2));
+    y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(kLogP3));
+    y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(kLogP4));
+    y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(kLogP5));
+    y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(kLogP6));
+    y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(kLogP7));
+    y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(kLogP8));
+    y = _mm256_mul_ps(_mm256_mul_ps(y, x), z);
+
+    y = _mm256_fmadd_ps(e, _mm256_set1_ps(kLogQ1), y);
+    y = _mm256_fnmadd_ps(z, _mm256_set1_ps(0.5f), y);
+    x = _mm256_add_ps(x, y);
+    return _mm256_fmadd_ps(e, _mm256_set1_ps(kLogQ2), x);
+}
+
+SIMD_TARGET_AVX2 void multiplyAvx2(const float* a, const float* b, float* out, size_t count) {
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        _mm256_storeu_ps(out + i, _mm256_mul_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i)));
+    }
+    multiplyScalar(a + i, b + i, out + i, count - i);
+}
+
+SIMD_TARGET_AVX2 void mixAddAvx2(const float* in, float* out, size_t count, float gain) {
+    const __m256 gainV = _mm256_set1_ps(gain);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        _mm256_storeu_ps(out + i, _mm256_fmadd_ps(_mm256_loadu_ps(in + i), gainV, _mm256_loadu_ps(out + i)));
+    }
+    mixAddScalar(in + i, out + i, count - i, gain);
+}
+
+SIMD_TARGET_AVX2 void complexMagnitudeAvx2(const float* interleaved, float* out, size_t count) {
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 first = _mm256_loadu_ps(interleaved + 2 * i);      // bins 0..3
+        __m256 second = _mm256_loadu_ps(interleaved + 2 * i + 8); // bins 4..7
+        // hadd works per 128-bit lane and yields bins 0 1 4 5 | 2 3 6 7
+        __m256 power = _mm256_hadd_ps(_mm256_mul_ps(first, first), _mm256_mul_ps(second, second));
+        power = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(power), _MM_SHUFFLE(3, 1, 2, 0)));
+        _mm256_storeu_ps(out + i, _mm256_sqrt_ps(power));
+    }
+    complexMagnitudeScalar(interleaved + 2 * i, out + i, count - i);
+}
+
+SIMD_TARGET_AVX2 float sumAvx2(const float* data, size_t count) {
+    __m256 acc = _mm256_setzero_ps();
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        acc = _mm256_add_ps(acc, _mm256_loadu_ps(data + i));
+    }
+    return horizontalSum256(acc) + sumScalar(data + i, count - i);
+}
+
+SIMD_TARGET_AVX2 void downmixAvx2(const float* interleaved, float* out, size_t frames, int channels) {
+    const __m256 scale = _mm256_set1_ps(1.0f / channels);
+    size_t i = 0;
+    if (channels == 2) {
+        for (; i + 8 <= frames; i += 8) {
+            __m256 first = _mm256_loadu_ps(interleaved + 2 * i);      // frames 0-3
+            __m256 second = _mm256_loadu_ps(interleaved + 2 * i + 8); // frames 4-7
+            __m256 sums = _mm256_hadd_ps(first, second);              // f0 f1 f4 f5 | f2 f3 f6 f7
+            sums = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(sums), _MM_SHUFFLE(3, 1, 2, 0)));
+            _mm256_storeu_ps(out + i, _mm256_mul_ps(sums, scale));
+        }
+    } else {
+        // Gather one channel of eight frames per step, for any channel count
+        const __m256i offsets = _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), _mm256_set1_epi32(channels));
+        for (; i + 8 <= frames; i += 8) {
+            const float* frame = interleaved + i * channels;
+            __m256 acc = _mm256_setzero_ps();
+            for (int c = 0; c < channels; ++c) {
+                acc = _mm256_add_ps(acc, _mm256_i32gather_ps(frame + c, offsets, 4));
+            }
+            _mm256_storeu_ps(out + i, _mm256_mul_ps(acc, scale));
+        }
+    }
+    downmixScalar(interleaved + i * channels, out + i, frames - i, channels);
+}
+
+SIMD_TARGET_AVX2 float dotAvx2(const float* a, const float* b, size_t count) {
+    __m256 acc = _mm256_setzero_ps();
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        acc = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), acc);
+    }
+    return horizontalSum256(acc) + dotScalar(a + i, b + i, count - i);
+}
+
+SIMD_TARGET_AVX2 float maxAvx2(const float* data, size_t count) {
+    if (count < 8) {
+        return maxScalar(data, count);
+    }
+    __m256 acc = _mm256_loadu_ps(data);
+    size_t i = 8;
+    for (; i + 8 <= count; i += 8) {
+        acc = _mm256_max_ps(acc, _mm256_loadu_ps(data + i));
+    }
+    float result = horizontalMax256(acc);
+    return i < count ? std::max(result, maxScalar(data + i, count - i)) : result;
+}
+
+SIMD_TARGET_AVX2 void blockStatsAvx2(const float* data, size_t count, size_t blockSize, float* mins, float* maxs, float* energies) {
+    for (size_t block = 0, start = 0; start < count; ++block, start += blockSize) {
+        size_t length = std::min(blockSize, count - start);
+        const float* in = data + start;
+        if (length < 8) {
+            blockStatsSse41(in, length, length, mins + block, maxs + block, energies + block);
+            continue;
+        }
+        __m256 low = _mm256_loadu_ps(in);
+        __m256 high = low;
+        __m256 energy = _mm256_mul_ps(low, low);
+        size_t i = 8;
+        for (; i + 8 <= length; i += 8) {
+            __m256 v = _mm256_loadu_ps(in + i);
+            low = _mm256_min_ps(low, v);
+            high = _mm256_max_ps(high, v);
+            energy = _mm256_fmadd_ps(v, v, energy);
+        }
+        mins[block] = horizontalMin256(low);
+        maxs[block] = horizontalMax256(high);
+        energies[block] = horizontalSum256(energy);
+        if (i < length) {
+            float tailMin, tailMax, tailEnergy;
+            blockStatsScalar(in + i, length - i, length - i, &tailMin, &tailMax, &tailEnergy);
+            mins[block] = std::min(mins[block], tailMin);
+            maxs[block] = std::max(maxs[block], tailMax);
+            energies[block] += tailEnergy;
+        }
+    }
+}
+
+SIMD_TARGET_AVX2 void log10OnePlusAvx2(float* data, size_t count, float scale) {
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 factor = _mm256_set1_ps(kLog10OfE * scale);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 v = _mm256_add_ps(one, _mm256_loadu_ps(data + i));
+        _mm256_storeu_ps(data + i, _mm256_mul_ps(log256(v), factor));
+    }
+    log10OnePlusScalar(data + i, count - i, scale);
+}
+
+SIMD_TARGET_AVX2 void log10RemapAvx2(float* data, size_t count, float floor, float offset, float scale) {
+    const __m256 floorV = _mm256_set1_ps(floor);
+    const __m256 log10E = _mm256_set1_ps(kLog10OfE);
+    const __m256 offsetV = _mm256_set1_ps(offset);
+    const __m256 scaleV = _mm256_set1_ps(scale);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 v = _mm256_max_ps(_mm256_loadu_ps(data + i), floorV);
+        __m256 log10V = _mm256_mul_ps(log256(v), log10E);
+        _mm256_storeu_ps(data + i, _mm256_mul_ps(_mm256_sub_ps(log10V, offsetV), scaleV));
+    }
+    log10RemapScalar(data + i, count - i, floor, offset, scale);
+}
+
+InstructionSet detectInstructionSet() {
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    const int maxLeaf = info[0];
+    __cpuid(info, 1);
+    const bool sse41 = (info[2] & (1 << 19)) != 0;
+    const bool fma = (info[2] & (1 << 12)) != 0;
+    const bool osAvx = (info[2] & (1 << 27)) != 0 && (info[2] & (1 << 28)) != 0 &&
+                       (_xgetbv(0) & 0x6) == 0x6; // OS saves the YMM state
+    bool avx2 = false;
+    if (maxLeaf >= 7) {
+        __cpuidex(info, 7, 0);
+        avx2 = (info[1] & (1 << 5)) != 0;
+    }
+    if (avx2 && fma && osAvx) {
+        return InstructionSet::AVX2;
+    }
+    return sse41 ? InstructionSet::SSE41 : InstructionSet::Scalar;
+#else
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        return InstructionSet::AVX2;
+    }
+    return __builtin_cpu_supports("sse4.1") ? InstructionSet::SSE41 : InstructionSet::Scalar;
+#endif
+}
+
+#else
+
+InstructionSet detectInstructionSet() {
+    return InstructionSet::Scalar;
+}
+
+#endif // SIMD_KERNELS_X86
+
+struct KernelTable {
+    void (*multiply)(const float*, const float*, float*, size_t);
+    void (*complexMagnitude)(const float*, float*, size_t);
+    float (*sum)(const float*, size_t);
+    float (*dot)(const float*, const float*, size_t);
+    float (*max)(const float*, size_t);
+    void (*log10OnePlus)(float*, size_t, float);
+    void (*log10Remap)(float*, size_t, float, float, float);
+    void (*downmix)(const float*, float*, size_t, int);
+    void (*blockStats)(const float*, size_t, size_t, float*, float*, float*);
+    void (*mixAdd)(const float*, float*, size_t, float);
+};
+
+const KernelTable kScalarKernels = {
+    multiplyScalar, complexMagnitudeScalar, sumScalar, dotScalar, maxScalar, log10OnePlusScalar, log10RemapScalar, downmixScalar,
+    blockStatsScalar, mixAddScalar
+};
+
+#if defined(SIMD_KERNELS_X86)
+const KernelTable kSse41Kernels = {
+    multiplySse41, complexMagnitudeSse41, sumSse41, dotSse41, maxSse41, log10OnePlusSse41, log10RemapSse41, downmixSse41,
+    blockStatsSse41, mixAddSse41
+};
+const KernelTable kAvx2Kernels = {
+    multiplyAvx2, complexMagnitudeAvx2, sumAvx2, dotAvx2, maxAvx2, log10OnePlusAvx2, log10RemapAvx2, downmixAvx2,
+    blockStatsAvx2, mixAddAvx2
+};
+#endif
+
+InstructionSet supportedInstructionSet() {
+    static const InstructionSet detected = detectInstructionSet();
+    return detected;
+}
+
+std::atomic<int> instructionSetLimit{ static_cast<int>(InstructionSet::AVX2) };
+
+const KernelTable& kernels() {
+    InstructionSet set = activeInstructionSet();
+#if defined(SIMD_KERNELS_X86)
+    if (set == InstructionSet::AVX2) {
+        return kAvx2Kernels;
+    }
+    if (set == InstructionSet::SSE41) {
+        return kSse41Kernels;
+    }
+#endif
+    (void)set;
+    return kScalarKernels;
+}
+
+} // namespace
+
+InstructionSet activeInstructionSet() {
+    int limit = instructionSetLimit.load(std::memory_order_relaxed);
+    return static_cast<InstructionSet>(std::min(static_cast<int>(supportedInstructionSet()), limit));
+}
+
+const char* instructionSetName(InstructionSet set) {
+    switch (set) {
+    case InstructionSet::AVX2: return "AVX2";
+    case InstructionSet::SSE41: return "SSE4.1";
+    default: return "scalar";
+    }
+}
+
+void limitInstructionSet(InstructionSet maximum) {
+    instructionSetLimit.store(static_cast<int>(maximum), std::memory_order_relaxed);
+}
+
+void multiply(const float* a, const float* b, float* out, size_t count) {
+    kernels().multiply(a, b, out, count);
+}
+
+void complexMagnitude(const float* interleaved, float* out, size_t count) {
+    kernels().complexMagnitude(interleaved, out, count);
+}
+
+float sum(const float* data, size_t count) {
+    return kernels().sum(data, count);
+}
+
+float dot(const float* a, const float* b, size_t count) {
+    return kernels().dot(a, b, count);
+}
+
+float max(const float* data, size_t count) {
+    return kernels().max(data, count);
+}
+
+void log10OnePlus(float* data, size_t count, float scale) {
+    kernels().log10OnePlus(data, count, scale);
+}
+
+void log10Remap(float* data, size_t count, float floor, float offset, float scale) {
+    kernels().log10Remap(data, count, floor, offset, scale);
+}
+
+void downmix(const float* interleaved, float* out, size_t frames, int channels) {
+    kernels().downmix(interleaved, out, frames, channels);
+}
+
+void blockStats(const float* data, size_t count, size_t blockSize, float* mins, float* maxs, float* energies) {
+    kernels().blockStats(data, count, blockSize, mins, maxs, energies);
+}
+
+void mixAdd(const float* in, float* out, size_t count, float gain) {
+    kernels().mixAdd(in, out, count, gain);
+}
+
+} // namespace simd
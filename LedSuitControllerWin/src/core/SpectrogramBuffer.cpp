@@ -0,0 +1,85 @@
+#include "include/core/SpectrogramBuffer.h"
+#include <algorithm>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <utility>
+
+namespace {
+
+std::shared_ptr<void> allocateAligned(size_t bytes) {
+    void* block = ::operator new(std::max<size_t>(bytes, SpectrogramBuffer::kAlignment),
+                                 std::align_val_t(SpectrogramBuffer::kAlignment));
+    return std::shared_ptr<void>(block, [](void* p) {
+        ::operator delete(p, std::align_val_t(SpectrogramBuffer::kAlignment));
+    });
+}
+
+} // namespace
+
+SpectrogramBuffer::SpectrogramBuffer(size_t frames, size_t bins)
+    : binCount(bins), rowStride(strideFor(bins)), ownsStorage(true) {
+    resizeFrames(frames);
+}
+
+SpectrogramBuffer::SpectrogramBuffer(float* data, size_t frames, size_t bins, size_t stride, std::shared_ptr<void> keepAlive)
+    : owner(std::move(keepAlive)), storage(data), frameCount(frames), binCount(bins),
+      rowStride(stride), frameCapacity(frames), ownsStorage(false) {
+    if (stride < bins) {
+        throw std::invalid_argument("SpectrogramBuffer stride is smaller than the bin count.");
+    }
+}
+
+SpectrogramBuffer::SpectrogramBuffer(SpectrogramBuffer&& other) noexcept {
+    *this = std::move(other);
+}
+
+SpectrogramBuffer& SpectrogramBuffer::operator=(SpectrogramBuffer&& other) noexcept {
+    if (this != &other) {
+        owner = std::move(other.owner);
+        storage = std::exchange(other.storage, nullptr);
+        frameCount = std::exchange(other.frameCount, 0);
+        binCount = std::exchange(other.binCount, 0);
+        rowStride = std::exchange(other.rowStride, 0);
+        frameCapacity = std::exchange(other.frameCapacity, 0);
+        ownsStorage = std::exchange(other.ownsStorage, false);
+    }
+    return *this;
+}
+
+size_t SpectrogramBuffer::strideFor(size_t bins) {
+    const size_t floatsPerLine = kAlignment / sizeof(float);
+    return (bins + floatsPerLine - 1) / floatsPerLine * floatsPerLine;
+}
+
+void SpectrogramBuffer::reserveFrames(size_t capacity) {
+    if (capacity > frameCapacity) {
+        reallocate(capacity);
+    }
+}
+
+void SpectrogramBuffer::resizeFrames(size_t frames) {
+    if (frames > frameCapacity) {
+        reallocate(std::max(frames, frameCapacity * 2));
+    }
+    if (frames > frameCount) {
+        std::memset(row(frameCount), 0, (frames - frameCount) * rowStride * sizeof(float));
+    }
+    frameCount = frames;
+}
+
+void SpectrogramBuffer::reallocate(size_t capacity) {
+    if (!ownsStorage) {
+        throw std::logic_error("Cannot resize a SpectrogramBuffer that wraps external storage.");
+    }
+
+    std::shared_ptr<void> block = allocateAligned(capacity * rowStride * sizeof(float));
+    float* newStorage = static_cast<float*>(block.get());
+    if (frameCount > 0) {
+        std::memcpy(newStorage, storage, frameCount * rowStride * sizeof(float));
+    }
+
+    owner = std::move(block);
+    storage = newStorage;
+    frameCapacity = capacity;
+}
@@ -0,0 +1,140 @@
+#include "include/core/SpectrogramCache.h"
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QSaveFile>
+#include <QDebug>
+#include <cstdint>
+#include <cstring>
+
+namespace {
+
+const char kMagic[8] = { 'L', 'S', 'C', 'S', 'P', 'E', 'C', '1' };
+const uint32_t kFormatVersion = 1;
+
+// Fixed 64-byte header so the float payload that follows stays 64-byte aligned in the mapping
+struct CacheHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t headerSize;
+    uint64_t frames;
+    uint64_t bins;
+    uint64_t stride;
+    double audioDuration;
+    uint8_t reserved[16];
+};
+static_assert(sizeof(CacheHeader) == SpectrogramBuffer::kAlignment, "Cache header must keep the payload aligned");
+
+} // namespace
+
+SpectrogramCache::SpectrogramCache(const QString& cacheDirectory)
+    : directory(cacheDirectory) {
+    QDir dir(directory);
+    if (!dir.exists() && !dir.mkpath(".")) {
+        qWarning() << "Failed to create spectrogram cache directory at:" << directory;
+    }
+}
+
+QString SpectrogramCache::makeKey(const QString& audioFilePath, const std::string& analysisSignature) {
+    QFile file(audioFilePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qWarning() << "Cannot hash audio file for the spectrogram cache:" << audioFilePath;
+        return QString();
+    }
+
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    if (!hash.addData(&file)) {
+        return QString();
+    }
+    hash.addData(QByteArray::fromStdString(analysisSignature));
+    return QString::fromLatin1(hash.result().toHex());
+}
+
+QString SpectrogramCache::makeKeyFromHash(const QString& contentHash, const std::string& analysisSignature) {
+    if (contentHash.isEmpty()) {
+        return QString();
+    }
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(contentHash.toLatin1());
+    hash.addData(QByteArray::fromStdString(analysisSignature));
+    return QString::fromLatin1(hash.result().toHex());
+}
+
+QString SpectrogramCache::entryPath(const QString& key) const {
+    return directory + "/" + key + ".spec";
+}
+
+std::shared_ptr<SpectrogramBuffer> SpectrogramCache::load(const QString& key, double& audioDuration) const {
+    if (key.isEmpty()) {
+        return nullptr;
+    }
+
+    auto file = std::make_shared<QFile>(entryPath(key));
+    if (!file->open(QIODevice::ReadOnly)) {
+        return nullptr; // Miss
+    }
+
+    const qint64 fileSize = file->size();
+    if (fileSize < static_cast<qint64>(sizeof(CacheHeader))) {
+        qWarning() << "Ignoring truncated spectrogram cache entry:" << file->fileName();
+        return nullptr;
+    }
+
+    // Private mapping, so a stray write can never reach the file. Entries hold display-ready values
+    // and nothing writes to them, so the pages stay shared with the page cache.
+    uchar* mapped = file->map(0, fileSize, QFileDevice::MapPrivateOption);
+    if (!mapped) {
+        qWarning() << "Failed to map spectrogram cache entry:" << file->fileName();
+        return nullptr;
+    }
+
+    CacheHeader header;
+    std::memcpy(&header, mapped, sizeof(header));
+
+    // Bound frames by what the file can hold before multiplying, so a damaged header cannot wrap
+    const uint64_t availableBytes = static_cast<uint64_t>(fileSize) - sizeof(CacheHeader);
+    const bool sizeFits = header.stride > 0 && header.stride <= availableBytes / sizeof(float) &&
+                          header.frames <= availableBytes / (header.stride * sizeof(float));
+    if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 || header.version != kFormatVersion ||
+        header.headerSize != sizeof(CacheHeader) || header.stride < header.bins || !sizeFits ||
+        availableBytes != header.frames * header.stride * sizeof(float)) {
+        qWarning() << "Ignoring incompatible spectrogram cache entry:" << file->fileName();
+        return nullptr;
+    }
+
+    audioDuration = header.audioDuration;
+    float* payload = reinterpret_cast<float*>(mapped + sizeof(CacheHeader));
+
+    // The QFile keeps the mapping alive for as long as the buffer exists
+    return std::make_shared<SpectrogramBuffer>(payload, header.frames, header.bins, header.stride, file);
+}
+
+bool SpectrogramCache::store(const QString& key, const SpectrogramBuffer& spectrogram, double audioDuration) const {
+    if (key.isEmpty() || spectrogram.empty()) {
+        return false;
+    }
+
+    CacheHeader header = {};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kFormatVersion;
+    header.headerSize = sizeof(CacheHeader);
+    header.frames = spectrogram.frames();
+    header.bins = spectrogram.bins();
+    header.stride = spectrogram.stride();
+    header.audioDuration = audioDuration;
+
+    QSaveFile file(entryPath(key));
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "Failed to open spectrogram cache entry for writing:" << file.fileName();
+        return false;
+    }
+
+    const qint64 payloadBytes = static_cast<qint64>(spectrogram.sizeInBytes());
+    if (file.write(reinterpret_cast<const char*>(&header), sizeof(header)) != sizeof(header) ||
+        file.write(reinterpret_cast<const char*>(spectrogram.data()), payloadBytes) != payloadBytes) {
+        qWarning() << "Failed to write spectrogram cache entry:" << file.fileName();
+        file.cancelWriting();
+        return false;
+    }
+    return file.commit();
+}
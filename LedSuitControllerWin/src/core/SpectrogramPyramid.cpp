@@ -0,0 +1,42 @@
+#include "include/core/SpectrogramPyramid.h"
+#include <algorithm>
+#include <cmath>
+
+SpectrogramPyramid::SpectrogramPyramid(std::shared_ptr<SpectrogramBuffer> base, Aggregation aggregation) {
+    if (!base || base->empty()) {
+        return;
+    }
+    levels.push_back(std::move(base));
+
+    // Each level pairs up the frames of the one below it; an odd trailing frame is carried over
+    while (levels.back()->frames() > 1) {
+        const SpectrogramBuffer& source = *levels.back();
+        const size_t bins = source.bins();
+        auto coarser = std::make_shared<SpectrogramBuffer>((source.frames() + 1) / 2, bins);
+
+        for (size_t t = 0; t < coarser->frames(); ++t) {
+            const float* first = source.row(2 * t);
+            const float* second = (2 * t + 1 < source.frames()) ? source.row(2 * t + 1) : first;
+            float* target = coarser->row(t);
+
+            if (aggregation == Aggregation::Max) {
+                for (size_t bin = 0; bin < bins; ++bin) {
+                    target[bin] = std::max(first[bin], second[bin]);
+                }
+            } else {
+                for (size_t bin = 0; bin < bins; ++bin) {
+                    target[bin] = 0.5f * (first[bin] + second[bin]);
+                }
+            }
+        }
+        levels.push_back(std::move(coarser));
+    }
+}
+
+size_t SpectrogramPyramid::levelForFramesPerPixel(float framesPerPixel) const {
+    if (levels.empty() || framesPerPixel < 2.0f) {
+        return 0;
+    }
+    size_t level = static_cast<size_t>(std::floor(std::log2(framesPerPixel)));
+    return std::min(level, levels.size() - 1);
+}
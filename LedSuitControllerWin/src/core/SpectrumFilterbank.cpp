@@ -0,0 +1,208 @@
+#include "include/core/SpectrumFilterbank.h"
+#include "include/core/SimdKernels.h"
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <tuple>
+
+namespace {
+
+using CacheKey = std::tuple<int, int, int, int, int>; // scale, fftSize, sampleRate, maxFrequency, bandCount
+using CustomKey = std::tuple<int, int, std::vector<float>>; // fftSize, sampleRate, edges in Hz
+
+std::mutex cacheMutex;
+std::map<CacheKey, std::shared_ptr<const SpectrumFilterbank>> filterbankCache;
+std::map<CustomKey, std::shared_ptr<const SpectrumFilterbank>> customFilterbankCache;
+
+int maxBinFor(int fftSize, int sampleRate, int maxFrequency) {
+    int maxBin = static_cast<int>((maxFrequency / static_cast<float>(sampleRate / 2.0)) * (fftSize / 2));
+    return std::clamp(maxBin, 0, fftSize / 2);
+}
+
+// Turns candidate band edges into strictly increasing ones so that every band keeps at least
+// one bin, while leaving enough bins above each edge for the bands that follow it
+std::vector<int> separateEdges(const std::vector<int>& candidates, int inputBins) {
+    const int bandCount = static_cast<int>(candidates.size()) - 1;
+    std::vector<int> edges(candidates.size());
+    edges[0] = 0;
+    for (int i = 1; i <= bandCount; ++i) {
+        int lowest = edges[i - 1] + 1;
+        int highest = inputBins - (bandCount - i);
+        edges[i] = std::clamp(candidates[i], lowest, highest);
+    }
+    edges[bandCount] = inputBins;
+    return edges;
+}
+
+std::string describe(const char* scale, int fftSize, int sampleRate, int maxFrequency, int bandCount) {
+    return std::string(scale) + "-v2;fftSize=" + std::to_string(fftSize) +
+           ";sampleRate=" + std::to_string(sampleRate) +
+           ";maxFrequency=" + std::to_string(maxFrequency) +
+           ";bands=" + std::to_string(bandCount);
+}
+
+double hzToMel(double hz) {
+    return 2595.0 * std::log10(1.0 + hz / 700.0);
+}
+
+double melToHz(double mel) {
+    return 700.0 * (std::pow(10.0, mel / 2595.0) - 1.0);
+}
+
+} // namespace
+
+SpectrumFilterbank::SpectrumFilterbank(Scale scale, int inputBins, std::vector<Band> bands, std::string signature)
+    : bankScale(scale), binCount(inputBins), hasWeightedBands(false),
+      bandList(std::move(bands)), layoutSignature(std::move(signature)) {
+    for (const Band& band : bandList) {
+        hasWeightedBands = hasWeightedBands || !band.weights.empty();
+    }
+}
+
+std::shared_ptr<const SpectrumFilterbank> SpectrumFilterbank::logarithmic(int fftSize, int sampleRate, int maxFrequency, int bandCount) {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    CacheKey key{ static_cast<int>(Scale::Logarithmic), fftSize, sampleRate, maxFrequency, bandCount };
+    auto it = filterbankCache.find(key);
+    if (it != filterbankCache.end()) {
+        return it->second;
+    }
+
+    const int inputBins = maxBinFor(fftSize, sampleRate, maxFrequency) + 1;
+    bandCount = std::clamp(bandCount, 1, inputBins);
+
+    // Log-spaced edges over [0, inputBins)
+    std::vector<int> candidates(bandCount + 1);
+    for (int i = 0; i <= bandCount; ++i) {
+        candidates[i] = static_cast<int>(std::pow(10.0, i / static_cast<double>(bandCount) * std::log10(inputBins)) - 1.0);
+    }
+    std::vector<int> edges = separateEdges(candidates, inputBins);
+
+    std::vector<Band> bands(bandCount);
+    for (int i = 0; i < bandCount; ++i) {
+        bands[i].firstBin = edges[i];
+        bands[i].binCount = edges[i + 1] - edges[i];
+    }
+
+    auto bank = std::shared_ptr<const SpectrumFilterbank>(new SpectrumFilterbank(
+        Scale::Logarithmic, inputBins, std::move(bands), describe("log", fftSize, sampleRate, maxFrequency, bandCount)));
+    filterbankCache[key] = bank;
+    return bank;
+}
+
+std::shared_ptr<const SpectrumFilterbank> SpectrumFilterbank::mel(int fftSize, int sampleRate, int maxFrequency, int bandCount) {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    CacheKey key{ static_cast<int>(Scale::Mel), fftSize, sampleRate, maxFrequency, bandCount };
+    auto it = filterbankCache.find(key);
+    if (it != filterbankCache.end()) {
+        return it->second;
+    }
+
+    const int inputBins = maxBinFor(fftSize, sampleRate, maxFrequency) + 1;
+    bandCount = std::clamp(bandCount, 1, inputBins);
+    const double binHz = sampleRate / static_cast<double>(fftSize);
+    const double topHz = (inputBins - 1) * binHz;
+
+    // bandCount triangles need bandCount + 2 equally spaced mel points
+    std::vector<double> pointsHz(bandCount + 2);
+    for (int i = 0; i < bandCount + 2; ++i) {
+        pointsHz[i] = melToHz(hzToMel(topHz) * i / (bandCount + 1));
+    }
+
+    std::vector<Band> bands(bandCount);
+    for (int b = 0; b < bandCount; ++b) {
+        const double lower = pointsHz[b];
+        const double center = pointsHz[b + 1];
+        const double upper = pointsHz[b + 2];
+
+        int first = static_cast<int>(std::ceil(lower / binHz));
+        int last = std::min(static_cast<int>(std::floor(upper / binHz)), inputBins - 1);
+        std::vector<float> weights;
+        double total = 0.0;
+        for (int bin = first; bin <= last; ++bin) {
+            double hz = bin * binHz;
+            double weight = hz <= center ? (hz - lower) / (center - lower) : (upper - hz) / (upper - center);
+            weights.push_back(static_cast<float>(std::max(weight, 0.0)));
+            total += weights.back();
+        }
+
+        if (total <= 0.0) {
+            // Narrow low band that falls between two bins: use the nearest bin
+            first = std::clamp(static_cast<int>(std::lround(center / binHz)), 0, inputBins - 1);
+            weights.assign(1, 1.0f);
+            total = 1.0;
+        }
+        for (float& weight : weights) {
+            weight = static_cast<float>(weight / total);
+        }
+
+        bands[b].firstBin = first;
+        bands[b].binCount = static_cast<int>(weights.size());
+        bands[b].weights = std::move(weights);
+    }
+
+    auto bank = std::shared_ptr<const SpectrumFilterbank>(new SpectrumFilterbank(
+        Scale::Mel, inputBins, std::move(bands), describe("mel", fftSize, sampleRate, maxFrequency, bandCount)));
+    filterbankCache[key] = bank;
+    return bank;
+}
+
+std::shared_ptr<const SpectrumFilterbank> SpectrumFilterbank::custom(int fftSize, int sampleRate, const std::vector<float>& edgesHz) {
+    if (edgesHz.size() < 2 || !std::is_sorted(edgesHz.begin(), edgesHz.end())) {
+        throw std::invalid_argument("Custom filterbank needs at least two ascending band edges.");
+    }
+
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    CustomKey key{ fftSize, sampleRate, edgesHz };
+    auto it = customFilterbankCache.find(key);
+    if (it != customFilterbankCache.end()) {
+        return it->second;
+    }
+
+    const int maxFrequency = static_cast<int>(std::ceil(edgesHz.back()));
+    const int inputBins = maxBinFor(fftSize, sampleRate, maxFrequency) + 1;
+    const double binHz = sampleRate / static_cast<double>(fftSize);
+    const int bandCount = std::min(static_cast<int>(edgesHz.size()) - 1, inputBins);
+
+    std::vector<Band> bands(bandCount);
+    std::string signature = "custom-v2;fftSize=" + std::to_string(fftSize) + ";sampleRate=" + std::to_string(sampleRate) + ";edges=";
+    for (int i = 0; i < bandCount; ++i) {
+        int first = std::clamp(static_cast<int>(std::lround(edgesHz[i] / binHz)), 0, inputBins - 1);
+        int end = std::clamp(static_cast<int>(std::lround(edgesHz[i + 1] / binHz)), first + 1, inputBins);
+        bands[i].firstBin = first;
+        bands[i].binCount = end - first;
+        signature += std::to_string(first) + "-" + std::to_string(end) + ",";
+    }
+
+    auto bank = std::shared_ptr<const SpectrumFilterbank>(new SpectrumFilterbank(
+        Scale::Custom, inputBins, std::move(bands), signature));
+    customFilterbankCache[key] = bank;
+    return bank;
+}
+
+float SpectrumFilterbank::apply(const float* spectrum, float* out, double* scratch) const {
+    if (hasWeightedBands) {
+        // Sparse mat-vec: every band only touches its own non-zero weights
+        for (size_t b = 0; b < bandList.size(); ++b) {
+            const Band& band = bandList[b];
+            if (band.weights.empty()) {
+                out[b] = simd::sum(spectrum + band.firstBin, band.binCount) / band.binCount;
+            } else {
+                out[b] = simd::dot(spectrum + band.firstBin, band.weights.data(), band.binCount);
+            }
+        }
+    } else {
+        // Prefix sums turn every rectangular band into one subtraction, overlapping or not
+        scratch[0] = 0.0;
+        for (int bin = 0; bin < binCount; ++bin) {
+            scratch[bin + 1] = scratch[bin] + spectrum[bin];
+        }
+        for (size_t b = 0; b < bandList.size(); ++b) {
+            const Band& band = bandList[b];
+            double total = scratch[band.firstBin + band.binCount] - scratch[band.firstBin];
+            out[b] = static_cast<float>(total / band.binCount);
+        }
+    }
+    return std::max(0.0f, simd::max(out, bandList.size()));
+}
@@ -0,0 +1,164 @@
+#include "include/core/TrackLoader.h"
+#include "include/core/AudioPreprocessor.h"
+#include "include/core/SpectrogramCache.h"
+#include "include/core/SimdKernels.h"
+#include <QDir>
+#include <QMetaObject>
+#include <algorithm>
+#include <iostream>
+
+namespace {
+
+constexpr size_t kChunkFrames = 256; // Frames per framesReady signal
+
+} // namespace
+
+TrackLoader::TrackLoader(QObject* parent) : QObject(parent) {}
+
+TrackLoader::~TrackLoader() {
+    cancelRequested.store(true);
+    if (worker.joinable()) {
+        worker.join();
+    }
+}
+
+void TrackLoader::load(const QString& filePath, int sampleRate, int fftSize, int maxFrequency) {
+    cancel();
+    if (worker.joinable()) {
+        worker.join(); // Returns quickly, the old worker checks the cancel flag between blocks
+    }
+
+    cancelRequested.store(false);
+    loading = true;
+    quint64 generation = ++activeGeneration;
+    worker = std::thread(&TrackLoader::run, this, generation, filePath.toStdString(), sampleRate, fftSize, maxFrequency);
+}
+
+void TrackLoader::cancel() {
+    cancelRequested.store(true);
+    ++activeGeneration; // Drops everything the old worker still has in flight
+    if (loading) {
+        loading = false;
+        emit loadCancelled();
+    }
+}
+
+template <typename Fn>
+void TrackLoader::post(quint64 generation, Fn fn) {
+    QMetaObject::invokeMethod(this, [this, generation, fn = std::move(fn)]() mutable {
+        if (generation == activeGeneration) {
+            fn();
+        }
+    }, Qt::QueuedConnection);
+}
+
+void TrackLoader::run(quint64 generation, std::string filePath, int sampleRate, int fftSize, int maxFrequency) {
+    // 1) PCM first, so the player is usable before the analysis is done. A track that was
+    //    opened before is mapped from the decoded audio cache instead of being decoded again.
+    DecodedAudioCache audioCache;
+    std::shared_ptr<const DecodedAudio> audio = audioCache.open(QString::fromStdString(filePath), sampleRate, &cancelRequested);
+    if (!audio) {
+        if (!cancelRequested.load()) {
+            post(generation, [this]() {
+                loading = false;
+                emit loadFailed(tr("Failed to load the selected audio file."));
+            });
+        }
+        return;
+    }
+    const size_t sampleCount = audio->sampleCount();
+    const double duration = audio->duration();
+    post(generation, [this, audio]() {
+        emit pcmReady(audio);
+    });
+
+    // Waveform lane: a single pass over the PCM, cheap next to the analysis
+    auto waveform = std::make_shared<const WaveformOverview>(audio);
+    post(generation, [this, waveform]() {
+        emit waveformReady(waveform);
+    });
+    if (cancelRequested.load()) {
+        return;
+    }
+
+    // 2) Spectrogram, straight from the cache when this exact analysis was done before
+    SpectrogramCache cache(QDir::currentPath() + "/cache/spectrograms");
+    QString cacheKey = SpectrogramCache::makeKeyFromHash(audio->contentHash(),
+                                                         AudioPreprocessor::analysisSignature(sampleRate, fftSize, maxFrequency));
+    double cachedDuration = 0.0;
+    std::shared_ptr<SpectrogramBuffer> spectrogram = cache.load(cacheKey, cachedDuration);
+    if (spectrogram) {
+        std::cout << "Spectrogram cache hit for " << filePath << std::endl;
+        post(generation, [this, spectrogram, cachedDuration]() {
+            loading = false;
+            emit progressChanged(100);
+            emit spectrogramReady(spectrogram, cachedDuration);
+        });
+        return;
+    }
+
+    // 3) Analysis of the shared PCM, published in chunks of raw frames
+    const int hopSize = fftSize / 2;
+    const qint64 expectedFrames = sampleCount >= static_cast<size_t>(fftSize)
+        ? static_cast<qint64>((sampleCount - fftSize) / hopSize + 1) : 0;
+
+    auto chunk = std::make_shared<std::vector<float>>();
+    qint64 chunkStart = 0;
+    int chunkBins = 0;
+    float runningMax = 0.0f;
+
+    auto flushChunk = [&]() {
+        if (chunk->empty()) {
+            return;
+        }
+        qint64 chunkFrames = static_cast<qint64>(chunk->size() / chunkBins);
+        int percent = expectedFrames > 0
+            ? static_cast<int>(std::min<qint64>(100, (chunkStart + chunkFrames) * 100 / expectedFrames)) : 0;
+        post(generation, [this, first = chunkStart, frames = chunk, bins = chunkBins, maxValue = runningMax, percent]() {
+            emit framesReady(first, frames, bins, maxValue);
+            emit progressChanged(percent);
+        });
+        chunkStart += chunkFrames;
+        chunk = std::make_shared<std::vector<float>>();
+        chunk->reserve(kChunkFrames * chunkBins);
+    };
+
+    auto onFrame = [&](size_t frameIndex, const float* bins, int binCount) {
+        if (frameIndex == 0) {
+            chunkBins = binCount;
+            chunk->reserve(kChunkFrames * chunkBins);
+            post(generation, [this, binCount, expectedFrames, duration]() {
+                emit analysisStarted(binCount, expectedFrames, duration);
+            });
+        }
+        chunk->insert(chunk->end(), bins, bins + binCount);
+        runningMax = std::max(runningMax, simd::max(bins, binCount));
+        if (chunk->size() >= kChunkFrames * chunkBins) {
+            flushChunk();
+        }
+    };
+
+    AudioPreprocessor preprocessor;
+    preprocessor.setCancelFlag(&cancelRequested);
+    preprocessor.setAudio(audio, sampleRate, fftSize);
+    if (!preprocessor.computeSpectrogram(maxFrequency, onFrame)) {
+        if (!cancelRequested.load()) {
+            post(generation, [this]() {
+                loading = false;
+                emit analysisFailed(tr("Failed to compute the spectrogram."));
+            });
+        }
+        return;
+    }
+    flushChunk();
+
+    double analyzedDuration = preprocessor.getAudioDuration();
+    spectrogram = preprocessor.takeSpectrogram();
+    cache.store(cacheKey, *spectrogram, analyzedDuration);
+
+    post(generation, [this, spectrogram, analyzedDuration]() {
+        loading = false;
+        emit progressChanged(100);
+        emit spectrogramReady(spectrogram, analyzedDuration);
+    });
+}
@@ -0,0 +1,134 @@
+#include "include/core/WaveformOverview.h"
+#include "include/core/DecodedAudioCache.h"
+#include "include/core/SimdKernels.h"
+#include <algorithm>
+#include <cmath>
+
+WaveformOverview::WaveformOverview(std::shared_ptr<const DecodedAudio> decoded) : audio(std::move(decoded)) {
+    const size_t count = sampleCount();
+    if (count == 0) {
+        return;
+    }
+
+    Level base;
+    base.blockSize = kBaseBlock;
+    size_t blocks = (count + kBaseBlock - 1) / kBaseBlock;
+    base.mins.resize(blocks);
+    base.maxs.resize(blocks);
+    base.energies.resize(blocks);
+    simd::blockStats(audio->samples(), count, kBaseBlock, base.mins.data(), base.maxs.data(), base.energies.data());
+    levels.push_back(std::move(base));
+
+    // Halve until one block covers the whole track
+    while (levels.back().mins.size() > 1) {
+        const Level& finer = levels.back();
+        const size_t finerBlocks = finer.mins.size();
+        Level coarser;
+        coarser.blockSize = finer.blockSize * 2;
+        blocks = (finerBlocks + 1) / 2;
+        coarser.mins.resize(blocks);
+        coarser.maxs.resize(blocks);
+        coarser.energies.resize(blocks);
+        for (size_t i = 0; i < blocks; ++i) {
+            size_t a = 2 * i;
+            size_t b = std::min(a + 1, finerBlocks - 1);
+            coarser.mins[i] = std::min(finer.mins[a], finer.mins[b]);
+            coarser.maxs[i] = std::max(finer.maxs[a], finer.maxs[b]);
+            coarser.energies[i] = finer.energies[a] + (b != a ? finer.energies[b] : 0.0f);
+        }
+        levels.push_back(std::move(coarser));
+    }
+}
+
+size_t WaveformOverview::sampleCount() const {
+    return audio ? audio->sampleCount() : 0;
+}
+
+int WaveformOverview::sampleRate() const {
+    return audio ? audio->sampleRate() : 0;
+}
+
+double WaveformOverview::duration() const {
+    return audio ? audio->duration() : 0.0;
+}
+
+size_t WaveformOverview::memoryBytes() const {
+    size_t total = 0;
+    for (const Level& level : levels) {
+        total += 3 * level.mins.size() * sizeof(float);
+    }
+    return total;
+}
+
+void WaveformOverview::query(double startSample, double endSample, WaveformColumn* out, size_t width) const {
+    std::fill(out, out + width, WaveformColumn());
+    const size_t count = sampleCount();
+    if (width == 0 || count == 0 || endSample <= startSample) {
+        return;
+    }
+
+    // Coarsest level whose blocks still fit in one column; below the base block the PCM itself is cheap enough
+    const double samplesPerColumn = (endSample - startSample) / width;
+    const Level* level = nullptr;
+    if (samplesPerColumn >= kBaseBlock) {
+        size_t index = static_cast<size_t>(std::log2(samplesPerColumn / kBaseBlock));
+        level = &levels[std::min(index, levels.size() - 1)];
+    }
+
+    for (size_t x = 0; x < width; ++x) {
+        double columnStart = startSample + x * samplesPerColumn;
+        double columnEnd = columnStart + samplesPerColumn;
+        if (columnEnd <= 0.0 || columnStart >= static_cast<double>(count)) {
+            continue;
+        }
+        size_t begin = static_cast<size_t>(std::max(0.0, std::floor(columnStart)));
+        size_t end = std::min(count, static_cast<size_t>(std::ceil(columnEnd)));
+        end = std::max(end, begin + 1);
+        out[x] = level ? fromLevel(*level, begin, end) : fromSamples(begin, end);
+    }
+}
+
+std::vector<WaveformColumn> WaveformOverview::query(double startSample, double endSample, size_t width) const {
+    std::vector<WaveformColumn> columns(width);
+    query(startSample, endSample, columns.data(), width);
+    return columns;
+}
+
+std::vector<WaveformColumn> WaveformOverview::queryTime(double startSeconds, double endSeconds, size_t width) const {
+    const double rate = sampleRate();
+    return query(startSeconds * rate, endSeconds * rate, width);
+}
+
+WaveformColumn WaveformOverview::fromSamples(size_t begin, size_t end) const {
+    const float* samples = audio->samples();
+    WaveformColumn column;
+    column.min = samples[begin];
+    column.max = samples[begin];
+    float energy = 0.0f;
+    for (size_t i = begin; i < end; ++i) {
+        column.min = std::min(column.min, samples[i]);
+        column.max = std::max(column.max, samples[i]);
+        energy += samples[i] * samples[i];
+    }
+    column.rms = std::sqrt(energy / (end - begin));
+    return column;
+}
+
+WaveformColumn WaveformOverview::fromLevel(const Level& level, size_t begin, size_t end) const {
+    // Whole blocks touching the column, so peaks on a block edge are never lost
+    size_t first = begin / level.blockSize;
+    size_t last = std::min((end - 1) / level.blockSize, level.mins.size() - 1);
+
+    WaveformColumn column;
+    column.min = level.mins[first];
+    column.max = level.maxs[first];
+    float energy = 0.0f;
+    for (size_t block = first; block <= last; ++block) {
+        column.min = std::min(column.min, level.mins[block]);
+        column.max = std::max(column.max, level.maxs[block]);
+        energy += level.energies[block];
+    }
+    size_t covered = std::min(sampleCount(), (last + 1) * level.blockSize) - first * level.blockSize;
+    column.rms = std::sqrt(energy / covered);
+    return column;
+}
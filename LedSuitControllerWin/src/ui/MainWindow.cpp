@@ -1,5 +1,6 @@
 #include "include/ui/MainWindow.h"
 #include "include/core/AudioPlayer.h"
+#include "include/core/AudioPreprocessor.h"
 #include "include/ui/Preset.h"
 #include "include/ui/PresetManager.h"
 #include "include/core/SuitState.h"
@@ -29,20 +30,33 @@
 #include <QFileDialog>
 #include <QMessageBox>
 #include <QtNetwork/QUdpSocket>
+#include <QStatusBar>
+#include <QProgressBar>
+#include <QFileInfo>
 
- 
+namespace {
+
+// Analysis parameters shared by the track loader and the spectrogram view. The sample rate is
+// the output device's, since tracks are resampled to it while decoding.
+constexpr int kAnalysisFftSize = 1024;
+constexpr int kAnalysisMaxFrequency = 48000;
+
+} // namespace
 
 MainWindow::MainWindow(QWidget* parent)
     : QMainWindow(parent),
       centralContainer(new QWidget(this)),
       spectrogramView(new SpectrogramView(this)),
+      waveformLane(new WaveformLane(this)),
       leftWidget(new QWidget(this)), // Left widget for 1:5 split
       rightWidget(new QWidget(this)), // Right widget for 1:5 split
       audioPlayer(new AudioPlayer()),
+      trackLoader(new TrackLoader(this)),
       updateTimer(new QTimer(this)), // Allocate the timer
       waypointCompressor(new WaypointCompressor(spectrogramView)) {
     
     ensureConfigFiles(); // Ensure config files are created first
+    AudioPreprocessor::loadFftwWisdom((QDir::currentPath() + "/config/fftw_wisdom.dat").toStdString());
     
     numSuits = loadAppConfig(QDir::currentPath() + "/config/appconfig.json");
     loadSuitConfig(QDir::currentPath() + "/config/suits.json");
@@ -69,6 +83,8 @@ MainWindow::MainWindow(QWidget* parent)
     mainLayout->addLayout(splitLayout, 2);
 
     mainLayout->addWidget(spectrogramView, 1);
+    mainLayout->addWidget(waveformLane);
+    connect(spectrogramView, &SpectrogramView::visibleRangeChanged, waveformLane, &WaveformLane::setVisibleRange);
 
     // Prompt the user to select a music file
     QString filePath = QFileDialog::getOpenFileName(
@@ -84,22 +100,31 @@ MainWindow::MainWindow(QWidget* parent)
         return;
     }
 
-    // Load the audio file into the spectrogram
-    loadMusicFile(filePath.toStdString());
-
-    // Load the audio file into the player
-    if (!audioPlayer->loadFile(filePath.toStdString())) {
-        QMessageBox::critical(this, tr("Error"), tr("Failed to load the selected audio file."));
-        QTimer::singleShot(0, this, &QWidget::close); // Exit the application
-        return;
-    } else {
-        std::cout << "Audio file successfully loaded into AudioPlayer." << std::endl;
-    }
-
     // Connect the AudioPlayer to the SpectrogramView
     spectrogramView->connectAudioPlayer(audioPlayer);
     std::cout << "AudioPlayer connected to SpectrogramView." << std::endl;
 
+    connect(updateTimer, &QTimer::timeout, this, [this]() {
+        waveformLane->setCursorTime(audioPlayer->getCurrentTime());
+    });
+
+    // The end of the track pauses the player; bring the transport controls back to "Play"
+    connect(audioPlayer, &AudioPlayer::playbackFinished, this, [this]() {
+        updateTimer->stop();
+        spectrogramView->updateCursor();
+        waveformLane->setCursorTime(audioPlayer->getCurrentTime());
+        playPauseAction->setIcon(QIcon(":/icons/Play.png"));
+        playPauseAction->setText("Play");
+    });
+
+    connect(audioPlayer, &AudioPlayer::loopWrapped, this, [this](double loopStartSeconds) {
+        statusBar()->showMessage(tr("Looping from %1 s").arg(loopStartSeconds, 0, 'f', 2), 2000);
+    });
+
+    // Decode the file into the player and the spectrogram in the background; the window stays responsive
+    setupTrackLoader();
+    loadMusicFile(filePath.toStdString());
+
     // Connect the SpectrogramView's updatePictograms signal to MainWindow
     connect(spectrogramView, &SpectrogramView::updatePictograms, this, &MainWindow::applyWaypointState);
 
@@ -125,6 +150,12 @@ int MainWindow::loadAppConfig(const QString& configFilePath) {
     }
 
     QJsonObject obj = doc.object();
+
+    // "patient" spends longer on the first FFTW plan for a faster analysis; the plan is kept in the wisdom file
+    if (obj["fftwPlanner"].toString() == "patient") {
+        AudioPreprocessor::setPlannerRigor(AudioPreprocessor::PlannerRigor::Patient);
+    }
+
     return obj.contains("numSuits") && obj["numSuits"].isDouble() ? obj["numSuits"].toInt() : 8;
 }
 
@@ -228,6 +259,14 @@ void MainWindow::setupToolbar() {
     QAction* addWaypointAction = new QAction(addWaypointIcon, "Add Waypoint", this);
     QAction* distributeAction = new QAction(distributeIcon, "Send to Suits", this);
     QAction* lanTimingAction = new QAction(lanIcon, "LAN Timing Off", this);
+    QAction* beatGridAction = new QAction("Beat Grid", this);
+    QAction* metronomeAction = new QAction("Metronome Off", this);
+    QAction* snapAction = new QAction("Snap to Beat Off", this);
+    QAction* followAction = new QAction("Follow Off", this);
+    QAction* colormapAction = new QAction(QString("Colors: ") + SpectrogramColormap::name(spectrogramView->getColormap()), this);
+    metronomeAction->setCheckable(true);
+    snapAction->setCheckable(true);
+    followAction->setCheckable(true);
 
 
     // Toggle LAN timing state and update icon and text
@@ -237,6 +276,57 @@ void MainWindow::setupToolbar() {
         lanTimingAction->setText(lanTimingEnabled ? "LAN Timing On" : "LAN Timing Off");
     });
 
+    // Beat grid for the metronome and waypoint snapping; the first beat defaults to the cursor
+    connect(beatGridAction, &QAction::triggered, this, [this]() {
+        if (audioPlayer->getTotalDuration() <= 0.0) {
+            QMessageBox::information(this, "Beat Grid", "Load a track first.");
+            return;
+        }
+        const BeatGrid& current = audioPlayer->getBeatGrid();
+        bool ok = false;
+        double bpm = QInputDialog::getDouble(this, "Beat Grid", "Tempo (BPM):", current.isValid() ? current.bpm() : 120.0,
+                                             20.0, 400.0, 3, &ok);
+        if (!ok) {
+            return;
+        }
+        double firstBeat = QInputDialog::getDouble(this, "Beat Grid", "First beat (seconds):",
+                                                   current.isValid() ? current.firstBeatSeconds() : audioPlayer->getCurrentTime(),
+                                                   0.0, audioPlayer->getTotalDuration(), 4, &ok);
+        if (!ok) {
+            return;
+        }
+        int beatsPerBar = QInputDialog::getInt(this, "Beat Grid", "Beats per bar:", current.isValid() ? current.beatsPerBar() : 4,
+                                               1, 16, 1, &ok);
+        if (!ok) {
+            return;
+        }
+        audioPlayer->setBeatGrid(BeatGrid(bpm, firstBeat, beatsPerBar, audioPlayer->getSampleRate()));
+        spectrogramView->updateOverlays(); // Redraws the beat lines
+    });
+
+    connect(metronomeAction, &QAction::toggled, this, [this, metronomeAction](bool enabled) {
+        audioPlayer->setMetronomeEnabled(enabled);
+        metronomeAction->setText(enabled ? "Metronome On" : "Metronome Off");
+    });
+
+    // Cycle through the spectrogram color tables
+    connect(colormapAction, &QAction::triggered, this, [this, colormapAction]() {
+        int next = (static_cast<int>(spectrogramView->getColormap()) + 1) % SpectrogramColormap::kPaletteCount;
+        spectrogramView->setColormap(static_cast<SpectrogramColormap::Palette>(next));
+        colormapAction->setText(QString("Colors: ") + SpectrogramColormap::name(spectrogramView->getColormap()));
+    });
+
+    connect(snapAction, &QAction::toggled, this, [this, snapAction](bool enabled) {
+        spectrogramView->setSnapToBeat(enabled);
+        snapAction->setText(enabled ? "Snap to Beat On" : "Snap to Beat Off");
+    });
+
+    // Keep the playhead centered while playing
+    connect(followAction, &QAction::toggled, this, [this, followAction](bool enabled) {
+        spectrogramView->setFollowPlayhead(enabled);
+        followAction->setText(enabled ? "Follow On" : "Follow Off");
+    });
+
 
     connect(playPauseAction, &QAction::triggered, this, [this, playIcon, pauseIcon]() {
         if (!audioPlayer->isPlaying()) {
@@ -415,6 +505,12 @@ void MainWindow::setupToolbar() {
     toolBar->addAction(addWaypointAction);
     toolBar->addAction(distributeAction);
     toolBar->addAction(lanTimingAction);
+    toolBar->addSeparator();
+    toolBar->addAction(beatGridAction);
+    toolBar->addAction(metronomeAction);
+    toolBar->addAction(snapAction);
+    toolBar->addAction(followAction);
+    toolBar->addAction(colormapAction);
 
     // Add the toolbar to the main window
     addToolBar(Qt::TopToolBarArea, toolBar);
@@ -554,48 +650,99 @@ void MainWindow::applyPreset(const std::string& presetName) {
 
 
 void MainWindow::loadMusicFile(const std::string& filePath) {
-    try {
-        AudioPreprocessor preprocessor;
-        int fftSize = 1024;         // Example FFT size
-        int maxFrequency = 48000;  // Max frequency
+    if (audioPlayer->isPlaying()) {
+        stopAudio();
+    }
 
-        // Load the audio file
-        if (!preprocessor.loadFile(filePath, 48000, fftSize)) {
-            throw std::runtime_error("Failed to load audio file.");
-        }
+    // Playback stays disabled until the loader has decoded the PCM
+    playPauseAction->setEnabled(false);
+    loadProgressBar->setValue(0);
+    loadProgressBar->show();
+    cancelLoadButton->show();
+    statusBar()->showMessage(tr("Loading %1...").arg(QFileInfo(QString::fromStdString(filePath)).fileName()));
 
-        // Retrieve audio duration
-        float audioDuration = preprocessor.getAudioDuration(); // Add this method in AudioPreprocessor if missing
+    trackLoader->load(QString::fromStdString(filePath), audioPlayer->getSampleRate(), kAnalysisFftSize,
+                      kAnalysisMaxFrequency);
+}
 
-        // Compute the spectrogram
-        preprocessor.computeSpectrogram(maxFrequency);
 
-        // Get the computed spectrogram
-        const auto& spectrogram = preprocessor.getSpectrogram();
+void MainWindow::setupTrackLoader() {
+    // Progress indicator and cancel button in the status bar, only visible while a track loads
+    loadProgressBar = new QProgressBar(this);
+    loadProgressBar->setRange(0, 100);
+    loadProgressBar->setMaximumWidth(300);
+    loadProgressBar->setFormat(tr("Analyzing... %p%"));
+    cancelLoadButton = new QPushButton(tr("Cancel"), this);
+    statusBar()->addPermanentWidget(loadProgressBar);
+    statusBar()->addPermanentWidget(cancelLoadButton);
+    loadProgressBar->hide();
+    cancelLoadButton->hide();
+
+    auto hideProgress = [this]() {
+        loadProgressBar->hide();
+        cancelLoadButton->hide();
+    };
+
+    connect(cancelLoadButton, &QPushButton::clicked, trackLoader, &TrackLoader::cancel);
+    connect(trackLoader, &TrackLoader::progressChanged, loadProgressBar, &QProgressBar::setValue);
+
+    connect(trackLoader, &TrackLoader::pcmReady, this, [this](std::shared_ptr<const DecodedAudio> audio) {
+        audioPlayer->setAudio(std::move(audio));
+        playPauseAction->setEnabled(true);
+        statusBar()->showMessage(tr("Audio ready, analyzing spectrogram..."));
+        std::cout << "Audio file successfully loaded into AudioPlayer." << std::endl;
+    });
 
-        // Transpose the spectrogram if needed
-        size_t frequencyBins = spectrogram.size();
-        size_t timeFrames = spectrogram[0].size();
-        std::vector<std::vector<float>> transposedSpectrogram(timeFrames, std::vector<float>(frequencyBins, 0.0f));
+    connect(trackLoader, &TrackLoader::waveformReady, this, [this](std::shared_ptr<const WaveformOverview> waveform) {
+        audioPlayer->setWaveform(waveform);
+        waveformLane->setOverview(std::move(waveform));
+    });
 
-        for (size_t i = 0; i < frequencyBins; ++i) {
-            for (size_t j = 0; j < timeFrames; ++j) {
-                transposedSpectrogram[j][i] = spectrogram[i][j];
-            }
-        }
+    connect(trackLoader, &TrackLoader::analysisStarted, this, [this](int bins, qint64 expectedFrames, double duration) {
+        spectrogramView->beginProgressiveLoad(bins, static_cast<size_t>(expectedFrames), audioPlayer->getSampleRate(),
+                                              kAnalysisMaxFrequency, static_cast<float>(duration));
+    });
+
+    connect(trackLoader, &TrackLoader::framesReady, this,
+            [this](qint64 firstFrame, std::shared_ptr<std::vector<float>> frames, int bins, float runningMax) {
+        spectrogramView->appendFrames(static_cast<size_t>(firstFrame), frames->data(), frames->size() / bins, runningMax);
+    });
+
+    connect(trackLoader, &TrackLoader::spectrogramReady, this,
+            [this, hideProgress](std::shared_ptr<SpectrogramBuffer> spectrogram, double duration) {
+        hideProgress();
+        size_t timeFrames = spectrogram->frames();
+        size_t frequencyBins = spectrogram->bins();
 
-        // Load the transposed spectrogram into the view
-        spectrogramView->loadSpectrogram(transposedSpectrogram, 48000, maxFrequency, audioDuration);
+        // Load the spectrogram into the view
+        spectrogramView->loadSpectrogram(std::move(spectrogram), audioPlayer->getSampleRate(), kAnalysisMaxFrequency,
+                                         static_cast<float>(duration));
+        statusBar()->showMessage(tr("Track loaded"), 3000);
 
         // Debug: Verify correct orientation
         std::cout << "Spectrogram loaded with "
-                  << transposedSpectrogram.size() << " time frames and "
-                  << transposedSpectrogram[0].size() << " frequency bins. "
-                  << "Duration: " << audioDuration << " seconds." << std::endl;
+                  << timeFrames << " time frames and "
+                  << frequencyBins << " frequency bins. "
+                  << "Duration: " << duration << " seconds." << std::endl;
+    });
 
-    } catch (const std::exception& e) {
-        std::cerr << "Error loading music file: " << e.what() << std::endl;
-    }
+    connect(trackLoader, &TrackLoader::loadFailed, this, [this, hideProgress](const QString& message) {
+        hideProgress();
+        QMessageBox::critical(this, tr("Error"), message);
+        QTimer::singleShot(0, this, &QWidget::close); // Exit the application
+    });
+
+    connect(trackLoader, &TrackLoader::analysisFailed, this, [this, hideProgress](const QString& message) {
+        hideProgress();
+        statusBar()->showMessage(message, 5000);
+        std::cerr << "Error loading music file: " << message.toStdString() << std::endl;
+    });
+
+    connect(trackLoader, &TrackLoader::loadCancelled, this, [this, hideProgress]() {
+        hideProgress();
+        statusBar()->showMessage(tr("Loading cancelled"), 3000);
+        std::cout << "Track loading cancelled." << std::endl;
+    });
 }
 
 
@@ -688,14 +835,16 @@ void MainWindow::setupPictogramGrid() {
 
 
 void MainWindow::loadTestData() {
-    // Load test spectrogram data
-    std::vector<std::vector<float>> testData(513, std::vector<float>(10000, 0.0f));
+    // Load test spectrogram data (10000 time frames x 513 frequency bins)
+    auto testData = std::make_shared<SpectrogramBuffer>(10000, 513);
 
     // Fill with dummy data (e.g., gradient)
-    for (size_t i = 0; i < testData.size(); ++i) {
-        for (size_t j = 0; j < testData[i].size(); ++j) {
-            testData[i][j] = static_cast<float>(i) / 513.0f * std::sin(j / 100.0);
+    for (size_t j = 0; j < testData->frames(); ++j) {
+        float* frame = testData->row(j);
+        for (size_t i = 0; i < testData->bins(); ++i) {
+            frame[i] = static_cast<float>(i) / 513.0f * std::sin(j / 100.0);
         }
+        AudioPreprocessor::applyDisplayScaling(frame, testData->bins());
     }
 
     float testDuration = 100.0f; // Example duration in seconds for the test data
@@ -707,7 +856,7 @@ void MainWindow::playAudio() {
     if (!audioPlayer->isPlaying()) {
         std::cout << "Audio is not playing. Starting playback." << std::endl;
         audioPlayer->play();
-        connect(updateTimer, &QTimer::timeout, spectrogramView, &SpectrogramView::updateCursor);
+        connect(updateTimer, &QTimer::timeout, spectrogramView, &SpectrogramView::updateCursor, Qt::UniqueConnection);
         updateTimer->start(5); // Sync cursor updates every 30 ms
     } else {
         std::cout << "Audio is already playing." << std::endl;
@@ -0,0 +1,63 @@
+#include "include/ui/SpectrogramColormap.h"
+#include <QColor>
+#include <cmath>
+#include <cstddef>
+
+namespace {
+
+struct ControlPoint {
+    int r, g, b;
+};
+
+// Evenly spaced samples of the matplotlib maps; the table interpolates linearly between them
+const ControlPoint kInferno[] = {
+    { 0, 0, 4 }, { 31, 12, 72 }, { 85, 15, 109 }, { 136, 34, 106 }, { 186, 54, 85 },
+    { 227, 89, 51 }, { 249, 140, 10 }, { 249, 201, 50 }, { 252, 255, 164 }
+};
+const ControlPoint kViridis[] = {
+    { 68, 1, 84 }, { 72, 40, 120 }, { 62, 74, 137 }, { 49, 104, 142 }, { 38, 130, 142 },
+    { 31, 158, 137 }, { 53, 183, 121 }, { 109, 205, 89 }, { 180, 222, 44 }, { 253, 231, 37 }
+};
+
+template <size_t N>
+QRgb interpolate(const ControlPoint (&points)[N], int index, int size) {
+    double position = static_cast<double>(index) / (size - 1) * (N - 1);
+    size_t lower = std::min(static_cast<size_t>(position), N - 2);
+    double t = position - lower;
+    const ControlPoint& a = points[lower];
+    const ControlPoint& b = points[lower + 1];
+    return qRgb(static_cast<int>(std::lround(a.r + (b.r - a.r) * t)),
+                static_cast<int>(std::lround(a.g + (b.g - a.g) * t)),
+                static_cast<int>(std::lround(a.b + (b.b - a.b) * t)));
+}
+
+} // namespace
+
+SpectrogramColormap::SpectrogramColormap(Palette palette) : current(palette) {
+    for (int i = 0; i < kSize; ++i) {
+        switch (palette) {
+        case Palette::Grayscale:
+            table[i] = qRgb(i, i, i);
+            break;
+        case Palette::Inferno:
+            table[i] = interpolate(kInferno, i, kSize);
+            break;
+        case Palette::Viridis:
+            table[i] = interpolate(kViridis, i, kSize);
+            break;
+        default:
+            // Same as the per-pixel QColor::fromHsv the view used to do
+            table[i] = QColor::fromHsv(std::clamp(240 - i, 0, 240), 255, i).rgb();
+            break;
+        }
+    }
+}
+
+const char* SpectrogramColormap::name(Palette palette) {
+    switch (palette) {
+    case Palette::Grayscale: return "Grayscale";
+    case Palette::Inferno: return "Inferno";
+    case Palette::Viridis: return "Viridis";
+    default: return "Classic";
+    }
+}
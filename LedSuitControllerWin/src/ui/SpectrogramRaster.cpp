@@ -0,0 +1,33 @@
+#include "include/ui/SpectrogramRaster.h"
+#include <algorithm>
+
+SpectrogramRaster::SpectrogramRaster(std::shared_ptr<const SpectrogramBuffer> levelData, int levelShift, SpectrogramZoom zoom,
+                                     int rows, int bins, const SpectrogramColormap& colors)
+    : level(std::move(levelData)), shift(levelShift), geometry(zoom), colormap(colors) {
+    rowBins.resize(static_cast<size_t>(std::max(0, rows)));
+    // The view's original row mapping, which counts the 20-pixel time axis below the image
+    for (int y = 0; y < rows; ++y) {
+        int binIndex = static_cast<int>(((rows - y - 1 + 20) / static_cast<float>(rows)) * bins);
+        rowBins[y] = std::clamp(binIndex, 0, bins - 1);
+    }
+}
+
+void SpectrogramRaster::draw(int64_t firstPixel, int count, QRgb* pixels, size_t stride, size_t availableFrames) const {
+    const int64_t lastFrame = static_cast<int64_t>(level->frames()) - 1;
+    const int64_t available = static_cast<int64_t>(std::min(availableFrames, level->frames()));
+    const int rowCount = rows();
+    for (int x = 0; x < count; ++x) {
+        int64_t frameIndex = std::max<int64_t>(0, std::min(geometry.columnAt(firstPixel + x) >> shift, lastFrame));
+        QRgb* pixel = pixels + x;
+        if (frameIndex >= available) {
+            for (int y = 0; y < rowCount; ++y, pixel += stride) {
+                *pixel = qRgb(0, 0, 0);
+            }
+            continue;
+        }
+        const float* frame = level->row(static_cast<size_t>(frameIndex));
+        for (int y = 0; y < rowCount; ++y, pixel += stride) {
+            *pixel = colormap(frame[rowBins[y]]);
+        }
+    }
+}
@@ -0,0 +1,169 @@
+#include "include/ui/SpectrogramRenderer.h"
+#include <QFont>
+#include <QMetaObject>
+#include <QPainter>
+#include <QString>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+SpectrogramRenderer::SpectrogramRenderer(QObject* parent) : QObject(parent) {
+    worker = std::thread(&SpectrogramRenderer::run, this);
+}
+
+SpectrogramRenderer::~SpectrogramRenderer() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    worker.join();
+}
+
+void SpectrogramRenderer::render(SpectrogramFrameRequest request) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        pending = std::move(request); // A request that has not started yet is superseded
+        hasPending = true;
+    }
+    wake.notify_one();
+}
+
+void SpectrogramRenderer::run() {
+    for (;;) {
+        SpectrogramFrameRequest request;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [this]() { return stopping || hasPending; });
+            if (stopping) {
+                return;
+            }
+            request = std::move(pending);
+            hasPending = false;
+        }
+        if (!request.raster || request.width <= 0 || request.height <= 0) {
+            continue;
+        }
+        if (request.tiled && request.tileGeneration != tileCache.currentGeneration()) {
+            continue; // Made before the tiles were cleared; its raster is no longer the view's
+        }
+
+        auto start = std::chrono::high_resolution_clock::now();
+        QImage& image = buffers[backBuffer];
+        if (image.width() != request.width || image.height() != request.height) {
+            image = QImage(request.width, request.height, QImage::Format_RGB32);
+        }
+        int drawnColumns = request.width;
+        bool complete;
+        if (canShift(request)) {
+            // Scrolled: move the last frame by the pixel delta, draw the columns that came into view
+            const QImage& previous = buffers[backBuffer ^ 1];
+            const int delta = static_cast<int>(request.origin - shown.origin);
+            const int kept = request.width - std::abs(delta);
+            const int rows = std::min(request.raster->rows(), request.height);
+            const int keptTo = delta >= 0 ? 0 : -delta;
+            const int keptFrom = delta >= 0 ? delta : 0;
+            for (int y = 0; y < rows; ++y) {
+                const QRgb* source = reinterpret_cast<const QRgb*>(previous.constScanLine(y)) + keptFrom;
+                std::memcpy(reinterpret_cast<QRgb*>(image.scanLine(y)) + keptTo, source, kept * sizeof(QRgb));
+            }
+            drawnColumns = request.width - kept;
+            complete = drawColumns(request, image, delta >= 0 ? kept : 0, drawnColumns);
+        } else {
+            complete = drawColumns(request, image, 0, request.width);
+        }
+        drawTimeAxis(request, image);
+        auto end = std::chrono::high_resolution_clock::now();
+
+        // The GUI gets a shared copy; the next frame goes into the other buffer while this one is shown
+        QImage frame = image;
+        backBuffer ^= 1;
+        shown = std::move(request);
+        shownComplete = complete;
+        double milliseconds = std::chrono::duration<double, std::milli>(end - start).count();
+        QMetaObject::invokeMethod(this, [this, frame, milliseconds, drawnColumns]() {
+            emit frameReady(frame, milliseconds, drawnColumns);
+        }, Qt::QueuedConnection);
+    }
+}
+
+bool SpectrogramRenderer::canShift(const SpectrogramFrameRequest& request) const {
+    // Same pixels at the same zoom pixel: same raster (zoom, rows, colors), image size and loaded frames
+    return shownComplete && shown.raster == request.raster && shown.width == request.width &&
+           shown.height == request.height && shown.tiled == request.tiled &&
+           shown.tileGeneration == request.tileGeneration &&
+           shown.availableFrames == request.availableFrames &&
+           std::abs(request.origin - shown.origin) < request.width;
+}
+
+bool SpectrogramRenderer::drawColumns(const SpectrogramFrameRequest& request, QImage& image, int x, int count) {
+    const SpectrogramRaster& raster = *request.raster;
+    if (count <= 0) {
+        return true;
+    }
+    if (!request.tiled) {
+        raster.draw(request.origin + x, count, reinterpret_cast<QRgb*>(image.bits()) + x,
+                    static_cast<size_t>(image.bytesPerLine()) / sizeof(QRgb), request.availableFrames);
+        return true;
+    }
+
+    // Blit the cached tiles; missing ones are black until a tile worker has rendered them
+    const int rows = std::min(raster.rows(), request.height);
+    const int tileWidth = SpectrogramTileCache::kTileWidth;
+    const int64_t firstPixel = request.origin + x;
+    const int64_t firstTile = firstPixel / tileWidth;
+    const int64_t lastTile = (firstPixel + count - 1) / tileWidth;
+    const int64_t trackTiles = (raster.zoom().pixelAt(static_cast<int64_t>(raster.source()->frames()) << raster.levelShift()) +
+                                tileWidth - 1) / tileWidth;
+    QPainter painter(&image);
+    std::vector<int64_t> missing;
+    for (int64_t tile = firstTile; tile <= lastTile; ++tile) {
+        // The part of the tile inside the columns being drawn
+        const int64_t from = std::max(firstPixel, tile * tileWidth);
+        const int64_t to = std::min(firstPixel + count, (tile + 1) * tileWidth);
+        const int targetX = static_cast<int>(from - request.origin);
+        const int width = static_cast<int>(to - from);
+        QImage tileImage = tileCache.find(raster, tile);
+        if (tileImage.isNull()) {
+            painter.fillRect(targetX, 0, width, rows, Qt::black);
+            missing.push_back(tile);
+        } else {
+            painter.drawImage(targetX, 0, tileImage, static_cast<int>(from - tile * tileWidth), 0, width, rows);
+        }
+    }
+    painter.end();
+    const bool complete = missing.empty();
+
+    // Missing tiles first, then one on each side of the view for the next scroll step
+    const int64_t viewFirstTile = request.origin / tileWidth;
+    const int64_t viewLastTile = (request.origin + request.width - 1) / tileWidth;
+    if (viewLastTile + 1 < trackTiles) {
+        missing.push_back(viewLastTile + 1);
+    }
+    if (viewFirstTile > 0) {
+        missing.push_back(viewFirstTile - 1);
+    }
+    // Cleared while drawing: the tiles asked for are stale, the view has a newer frame on the way
+    tileCache.request(request.raster, missing, request.tileGeneration);
+    return complete;
+}
+
+void SpectrogramRenderer::drawTimeAxis(const SpectrogramFrameRequest& request, QImage& image) {
+    const int rows = std::min(request.raster->rows(), request.height);
+    QPainter painter(&image);
+
+    // Fill Time Axis Background
+    painter.fillRect(0, rows, request.width, request.height - rows, Qt::black);
+
+    // Render Time Axis
+    painter.setPen(Qt::white);
+    painter.setFont(QFont("Arial", 8));
+    for (int x = 0; x < request.width; x += 100) {
+        int sourceColumn = request.startColumn + static_cast<int>((x / static_cast<float>(request.width)) * request.visibleColumns);
+        double timeInSeconds = sourceColumn * request.secondsPerColumn;
+        painter.drawText(x, request.height - 5, QString::number(timeInSeconds, 'f', 1) + "s");
+    }
+    painter.end();
+}
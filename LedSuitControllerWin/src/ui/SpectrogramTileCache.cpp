@@ -0,0 +1,144 @@
+#include "include/ui/SpectrogramTileCache.h"
+#include <QMetaObject>
+#include <algorithm>
+#include <functional>
+
+SpectrogramTileCache::SpectrogramTileCache(size_t budgetBytes, QObject* parent) : QObject(parent), budget(budgetBytes) {
+    // A few workers: a tile takes well under a millisecond, the GUI thread keeps a core to itself
+    unsigned count = std::clamp(std::thread::hardware_concurrency() / 2, 1u, 4u);
+    for (unsigned i = 0; i < count; ++i) {
+        workers.emplace_back(&SpectrogramTileCache::run, this);
+    }
+}
+
+SpectrogramTileCache::~SpectrogramTileCache() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+        queue.clear();
+    }
+    wake.notify_all();
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+}
+
+size_t SpectrogramTileCache::KeyHash::operator()(const Key& key) const {
+    size_t hash = std::hash<int64_t>()(key.tile);
+    hash ^= std::hash<const void*>()(key.source) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+    hash ^= std::hash<int>()(key.rows) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+    hash ^= std::hash<int>()(key.zoom.visibleColumns) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+    hash ^= std::hash<int>()(key.zoom.width) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+    return hash;
+}
+
+void SpectrogramTileCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    tiles.clear();
+    recentTiles.clear();
+    rendering.clear();
+    queue.clear();
+    bytes = 0;
+    ++generation;
+}
+
+QImage SpectrogramTileCache::find(const SpectrogramRaster& raster, int64_t tile) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = tiles.find(Key(raster, tile));
+    if (it == tiles.end()) {
+        return QImage();
+    }
+    recentTiles.splice(recentTiles.begin(), recentTiles, it->second.recent);
+    return it->second.image;
+}
+
+void SpectrogramTileCache::request(std::shared_ptr<const SpectrogramRaster> raster, const std::vector<int64_t>& wanted,
+                                   uint64_t requestGeneration) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (requestGeneration != generation) {
+            return; // For a view from before clear(); the waiting tiles are from a newer request
+        }
+        queue.clear();
+        for (int64_t tile : wanted) {
+            Key key(*raster, tile);
+            if (tile >= 0 && tiles.find(key) == tiles.end() && rendering.find(key) == rendering.end()) {
+                queue.push_back(Job{ raster, key });
+            }
+        }
+        if (queue.empty()) {
+            return;
+        }
+    }
+    wake.notify_all();
+}
+
+uint64_t SpectrogramTileCache::currentGeneration() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return generation;
+}
+
+size_t SpectrogramTileCache::memoryBytes() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return bytes;
+}
+
+size_t SpectrogramTileCache::tileCount() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return tiles.size();
+}
+
+void SpectrogramTileCache::run() {
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;) {
+        wake.wait(lock, [this]() { return stopping || !queue.empty(); });
+        if (stopping) {
+            return;
+        }
+        Job job = std::move(queue.front());
+        queue.pop_front();
+        if (tiles.find(job.key) != tiles.end() || !rendering.insert(job.key).second) {
+            continue;
+        }
+        const uint64_t jobGeneration = generation;
+        lock.unlock();
+
+        QImage image(kTileWidth, std::max(1, job.raster->rows()), QImage::Format_RGB32);
+        image.fill(Qt::black);
+        job.raster->draw(job.key.tile * kTileWidth, kTileWidth, reinterpret_cast<QRgb*>(image.bits()),
+                         static_cast<size_t>(image.bytesPerLine()) / sizeof(QRgb));
+
+        lock.lock();
+        if (jobGeneration != generation) {
+            continue; // Cleared meanwhile; the rendering set was reset with it
+        }
+        rendering.erase(job.key);
+        insert(job.key, std::move(image), std::move(job.raster));
+
+        // One queued notification at a time, however many tiles finish before the GUI gets to it
+        if (!notifyPending.exchange(true)) {
+            QMetaObject::invokeMethod(this, [this]() {
+                notifyPending.store(false);
+                emit tileReady();
+            }, Qt::QueuedConnection);
+        }
+    }
+}
+
+void SpectrogramTileCache::insert(const Key& key, QImage image, std::shared_ptr<const SpectrogramRaster> raster) {
+    bytes += bytesOf(image);
+    recentTiles.push_front(key);
+    tiles.insert_or_assign(key, Entry{ std::move(image), recentTiles.begin(), std::move(raster) });
+
+    // Least recently used out first; the tile just added always stays
+    while (bytes > budget && recentTiles.size() > 1) {
+        auto oldest = tiles.find(recentTiles.back());
+        bytes -= bytesOf(oldest->second.image);
+        tiles.erase(oldest);
+        recentTiles.pop_back();
+    }
+}
+
+size_t SpectrogramTileCache::bytesOf(const QImage& image) {
+    return static_cast<size_t>(image.sizeInBytes());
+}
@@ -1,10 +1,18 @@
 #include "include/ui/SpectrogramView.h"
 #include "include/core/AudioPlayer.h"
+#include "include/core/AudioPreprocessor.h"
+#include "include/core/SimdKernels.h"
+#include "include/ui/SpectrogramRenderer.h"
 #include <QGraphicsPixmapItem>
+#include <QGraphicsPathItem>
+#include <QGraphicsRectItem>
+#include <QPainterPath>
+#include <QPen>
 #include <QWheelEvent>
 #include <QImage>
 #include <QPainter>
 #include <cmath>
+#include <algorithm>
 #include <iostream>
 #include <QScrollBar>
 #include <chrono>
@@ -21,14 +29,39 @@ SpectrogramView::SpectrogramView(QWidget* parent)
     spectrogramItem = new QGraphicsPixmapItem();
     scene->addItem(spectrogramItem);
 
-    // Create a layer for the cursor
-    cursorItem = new QGraphicsPixmapItem();
-    scene->addItem(cursorItem);
+    // Overlays: beat grid, loop region and playhead. Persistent items that are reshaped when the
+    // range changes and moved on a cursor tick, instead of a window-sized image per tick.
+    beatItem = new QGraphicsPathItem();
+    beatItem->setPen(QPen(QColor(255, 255, 255, 45), 1));
+    scene->addItem(beatItem);
+    downbeatItem = new QGraphicsPathItem();
+    downbeatItem->setPen(QPen(QColor(255, 255, 255, 110), 1));
+    scene->addItem(downbeatItem);
+    loopItem = new QGraphicsRectItem();
+    loopItem->setPen(Qt::NoPen);
+    loopItem->setBrush(QColor(255, 255, 255, 40));
+    scene->addItem(loopItem);
+    loopEdgesItem = new QGraphicsPathItem();
+    loopEdgesItem->setPen(QPen(Qt::white, 1));
+    scene->addItem(loopEdgesItem);
+    playheadItem = new QGraphicsLineItem();
+    playheadItem->setPen(QPen(Qt::red, 2));
+    playheadItem->hide();
+    scene->addItem(playheadItem);
 
     // Create a layer for waypoints
     waypointLayer = new QGraphicsItemGroup();
     scene->addItem(waypointLayer);
 
+    // Frames are drawn off the GUI thread; every batch of finished tiles asks for a new frame
+    renderer = new SpectrogramRenderer(this);
+    connect(renderer, &SpectrogramRenderer::frameReady, this, &SpectrogramView::showFrame);
+    connect(&renderer->tiles(), &SpectrogramTileCache::tileReady, this, [this]() {
+        if (!pyramid.empty()) {
+            updateView();
+        }
+    });
+
     // Disable the vertical scrollbar
     setVerticalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
     setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
@@ -43,32 +76,30 @@ SpectrogramView::SpectrogramView(QWidget* parent)
 
 
 
-void SpectrogramView::loadSpectrogram(const std::vector<std::vector<float>>& data, int sampleRate, int maxFrequency, float audioDuration) {
-    spectrogramData = data;
+void SpectrogramView::loadSpectrogram(std::shared_ptr<SpectrogramBuffer> data, int sampleRate, int maxFrequency, float audioDuration) {
+    if (!data || data->empty()) {
+        std::cerr << "Cannot load an empty spectrogram." << std::endl;
+        return;
+    }
     this->sampleRate = sampleRate;
     this->maxFrequency = maxFrequency;
     this->duration = audioDuration; // Set the duration
 
-    float scalingFactor = 1;
-    // Calculate target resolution using the scaling factor
-    int originalTimeFrames = static_cast<int>(data[0].size());
-    int originalFrequencyBins = static_cast<int>(data.size());
+    // Already display-scaled (by the analysis, or as stored in the cache), so a mapped cache entry
+    // stays untouched; only the zoom pyramid is built here
+    spectrogram = std::move(data);
 
-    int targetTimeFrames = static_cast<int>(originalTimeFrames * scalingFactor);
-    int targetFrequencyBins = static_cast<int>(originalFrequencyBins * scalingFactor);
-
-    std::cout << "Original Time Frames: " << originalTimeFrames 
-              << ", Original Frequency Bins: " << originalFrequencyBins << "\n";
-    std::cout << "Target Time Frames: " << targetTimeFrames 
-              << ", Target Frequency Bins: " << targetFrequencyBins << "\n";
-
-    // Downsample the spectrogram data
-    spectrogramData = downsampleSpectrogram(data, targetTimeFrames, targetFrequencyBins);
+    auto start = std::chrono::high_resolution_clock::now();
+    pyramid = SpectrogramPyramid(spectrogram, SpectrogramPyramid::Aggregation::Max);
+    renderer->tiles().clear(); // Tiles of the previous track or of the progressive preview
+    auto end = std::chrono::high_resolution_clock::now();
 
+    std::cout << "Spectrogram pyramid built with " << pyramid.levelCount() << " levels in "
+              << std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count() << " ms\n";
 
-    std::cout << "Spectrogram time frames: " << spectrogramData[0].size()
+    std::cout << "Spectrogram time frames: " << getTimeFrames()
           << ", Audio duration: " << duration << " seconds"
-          << ", Frames per second: " << spectrogramData[0].size() / duration << std::endl;
+          << ", Frames per second: " << getTimeFrames() / duration << std::endl;
 
 
     // Update the view
@@ -78,6 +109,55 @@ void SpectrogramView::loadSpectrogram(const std::vector<std::vector<float>>& dat
 
 
 
+void SpectrogramView::beginProgressiveLoad(int bins, size_t expectedFrames, int sampleRate, int maxFrequency, float audioDuration) {
+    if (bins <= 0 || expectedFrames == 0) {
+        return;
+    }
+    this->sampleRate = sampleRate;
+    this->maxFrequency = maxFrequency;
+    this->duration = audioDuration;
+
+    // Full-length, zeroed buffer: frames that have not arrived yet are drawn black
+    spectrogram = std::make_shared<SpectrogramBuffer>(expectedFrames, static_cast<size_t>(bins));
+    pyramid = SpectrogramPyramid();
+    loadedFrames = 0;
+    renderer->tiles().clear();
+    progressiveRedrawTimer.invalidate();
+
+    updateView();
+    updateWaypointPositions();
+}
+
+
+
+void SpectrogramView::appendFrames(size_t firstFrame, const float* frames, size_t frameCount, float runningMax) {
+    if (!spectrogram || !pyramid.empty() || firstFrame >= spectrogram->frames()) {
+        return; // Not loading progressively (anymore)
+    }
+    frameCount = std::min(frameCount, spectrogram->frames() - firstFrame);
+    const size_t bins = spectrogram->bins();
+
+    // Same normalization as the final analysis, but against the largest magnitude seen so far
+    float logMax = std::log10(1.0f + runningMax);
+    for (size_t i = 0; i < frameCount; ++i) {
+        float* row = spectrogram->row(firstFrame + i);
+        std::copy(frames + i * bins, frames + (i + 1) * bins, row);
+        if (logMax > 0.0f) {
+            simd::log10OnePlus(row, bins, 1.0f / logMax);
+        }
+        AudioPreprocessor::applyDisplayScaling(row, bins);
+    }
+    // Frames arrive in order; the render thread only reads the ones finished before its request
+    loadedFrames = std::max(loadedFrames, firstFrame + frameCount);
+
+    if (!progressiveRedrawTimer.isValid() || progressiveRedrawTimer.elapsed() >= 200) {
+        updateView();
+        progressiveRedrawTimer.restart();
+    }
+}
+
+
+
 void SpectrogramView::setZoomLevel(float zoom) {
     zoomLevel = std::max(0.1f, zoom);
     qWarning() << "Zoom Level is : " << zoomLevel ;
@@ -161,6 +241,27 @@ void SpectrogramView::keyPressEvent(QKeyEvent* event) {
         }
     }
 
+    // Loop region for rehearsals, in device samples so the player can wrap sample-accurately
+    if (audioPlayer && (event->key() == Qt::Key_BracketLeft || event->key() == Qt::Key_BracketRight)) {
+        uint64_t cursorSample = static_cast<uint64_t>(snapTime(audioPlayer->getCurrentTime()) * audioPlayer->getSampleRate() + 0.5);
+        uint64_t loopStart = audioPlayer->getLoopStart();
+        uint64_t loopEnd = audioPlayer->hasLoopRegion() ? audioPlayer->getLoopEnd()
+                                                        : static_cast<uint64_t>(duration * audioPlayer->getSampleRate());
+        if (event->key() == Qt::Key_BracketLeft) {
+            loopStart = cursorSample;
+        } else {
+            loopEnd = cursorSample;
+        }
+        audioPlayer->setLoopRegion(loopStart, loopEnd);
+        updateOverlays();
+        return;
+    }
+    if (audioPlayer && event->key() == Qt::Key_L) {
+        audioPlayer->clearLoopRegion();
+        updateOverlays();
+        return;
+    }
+
     // Pass the event to the base class for default behavior
     QGraphicsView::keyPressEvent(event);
 }
@@ -168,7 +269,7 @@ void SpectrogramView::keyPressEvent(QKeyEvent* event) {
 
 
 void SpectrogramView::updateView() {
-    if (spectrogramData.empty()) {
+    if (!spectrogram || spectrogram->empty()) {
         std::cerr << "Spectrogram data is empty!" << std::endl;
         return;
     }
@@ -177,108 +278,141 @@ void SpectrogramView::updateView() {
 
     // Range Calculation
     int visibleColumns = static_cast<int>(width() / zoomLevel);
-    visibleColumns = std::clamp(visibleColumns, 1, static_cast<int>(spectrogramData[0].size()));
-    int maxOffset = static_cast<int>(spectrogramData[0].size()) - visibleColumns;
+    visibleColumns = std::clamp(visibleColumns, 1, getTimeFrames());
+    int maxOffset = getTimeFrames() - visibleColumns;
     currentOffset = std::clamp(currentOffset, 0, maxOffset);
     int startColumn = currentOffset;
-    int endColumn = std::min(startColumn + visibleColumns, static_cast<int>(spectrogramData[0].size()));
-
-    // Rendering Preparation
-    QImage spectrogramImage(width(), height(), QImage::Format_RGB32);
-    QPainter painter(&spectrogramImage);
-
-    // Render Spectrogram
-    for (int y = 0; y < height() - 20; ++y) {
-        int binIndex = static_cast<int>(((height() - y - 1) / static_cast<float>(height() - 20)) * spectrogramData.size());
-        binIndex = std::min(binIndex, static_cast<int>(spectrogramData.size()) - 1);
-
-        for (int x = 0; x < width(); ++x) {
-            int sourceColumn = startColumn + static_cast<int>((x / static_cast<float>(width())) * visibleColumns);
-            float normalizedAmplitude = spectrogramData[binIndex][sourceColumn];
-            int intensity = static_cast<int>(normalizedAmplitude * 255);
-            int hue = std::clamp(240 - intensity, 0, 240);
-            int saturation = 255;
-            int value = std::clamp(intensity, 0, 255);
-
-            QColor color = QColor::fromHsv(hue, saturation, value);
-            spectrogramImage.setPixel(x, y, color.rgb());
-        }
-    }
-
-
-
-    // Fill Time Axis Background
-    painter.fillRect(0, height() - 20, width(), 20, Qt::black);
-
-    // Render Time Axis
-    painter.setPen(Qt::white);
-    painter.setFont(QFont("Arial", 8));
-    float secondsPerColumn = duration / static_cast<float>(spectrogramData[0].size());
-    for (int x = 0; x < width(); x += 100) {
-        int sourceColumn = startColumn + static_cast<int>((x / static_cast<float>(width())) * visibleColumns);
-        float timeInSeconds = sourceColumn * secondsPerColumn;
-        QString timeLabel = QString::number(timeInSeconds, 'f', 1) + "s";
-        painter.drawText(x, height() - 5, timeLabel);
-    }
+    int endColumn = std::min(startColumn + visibleColumns, getTimeFrames());
 
-    painter.end();
+    // Screen pixel 0 is pixel `origin` of the zoom, counted from the start of the track (see SpectrogramZoom)
+    const int imageRows = std::max(0, height() - 20);
+    const SpectrogramZoom zoom{ visibleColumns, width() };
+    updateRaster(zoom, imageRows);
+    float secondsPerColumn = duration / static_cast<float>(getTimeFrames());
+
+    // The pixels are drawn on the render thread and shown when they arrive (see showFrame)
+    SpectrogramFrameRequest request;
+    request.raster = raster;
+    request.origin = zoom.pixelAt(startColumn);
+    request.width = width();
+    request.height = height();
+    request.tiled = !pyramid.empty();
+    request.tileGeneration = renderer->tiles().currentGeneration(); // After updateRaster, which may clear
+    request.availableFrames = pyramid.empty() ? loadedFrames : SIZE_MAX;
+    request.startColumn = startColumn;
+    request.visibleColumns = visibleColumns;
+    request.secondsPerColumn = secondsPerColumn;
+    renderer->render(std::move(request));
 
-    // Update Spectrogram Scene Layer
     if (!spectrogramItem) {
         spectrogramItem = new QGraphicsPixmapItem();
         scene->addItem(spectrogramItem);
     }
-    spectrogramItem->setPixmap(QPixmap::fromImage(spectrogramImage));
-    setSceneRect(0, 0, spectrogramImage.width(), spectrogramImage.height());
+    setSceneRect(0, 0, width(), height());
 
-    // Update Cursor Layer
-    updateCursorLayer();
+    // Overlays and playhead follow the new range
+    updateOverlays();
+
+    // Keep the waveform lane aligned with the visible columns
+    emit visibleRangeChanged(startColumn * secondsPerColumn, startColumn * secondsPerColumn + visibleColumns * secondsPerColumn);
 
     auto end = std::chrono::high_resolution_clock::now();
-    std::cout << "Total Update: " << std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count() << " ms\n";
+    frameRequested = start;
+    guiMilliseconds = std::chrono::duration<double, std::milli>(end - start).count();
 }
 
+void SpectrogramView::showFrame(const QImage& frame, double renderMilliseconds, int drawnColumns) {
+    // Swap the finished back buffer in; the GUI thread only converts and hands it to the scene
+    spectrogramItem->setPixmap(QPixmap::fromImage(frame));
 
-
-
-void SpectrogramView::updateCursorLayer() {
-    if (!cursorItem) {
-        cursorItem = new QGraphicsPixmapItem();
-        scene->addItem(cursorItem);
-    }
-
-    // Clear the cursor image
-    QImage cursorImage(width(), height(), QImage::Format_ARGB32);
-    cursorImage.fill(Qt::transparent);
-
-    // Render the cursor
-    QPainter painter(&cursorImage);
-    renderCursor(cursorImage, painter);
-    painter.end();
-
-    // Update the cursor layer
-    cursorItem->setPixmap(QPixmap::fromImage(cursorImage));
+    auto shown = std::chrono::high_resolution_clock::now();
+    std::cout << "Total Update: " << std::chrono::duration<double, std::milli>(shown - frameRequested).count()
+              << " ms to screen (GUI " << guiMilliseconds << " ms, render thread " << renderMilliseconds << " ms, "
+              << frame.width() << "x" << frame.height() << ", " << drawnColumns << " columns drawn, " << colormap.name() << ", "
+              << renderer->tiles().tileCount() << " tiles, " << renderer->tiles().memoryBytes() / (1024 * 1024)
+              << " MB cached)\n";
 }
 
 
 
 
-void SpectrogramView::renderCursor(QImage &image, QPainter &painter) {
-    if (cursorPosition < 0) return; // No cursor to render if position is invalid
-
+void SpectrogramView::updateCursorLayer() {
+    // One setPos per tick; the line itself only changes with the view height
     int visibleColumns = static_cast<int>(width() / zoomLevel);
     int startColumn = currentOffset;
-    int endColumn = std::min(startColumn + visibleColumns, static_cast<int>(spectrogramData[0].size()));
-
+    int endColumn = std::min(startColumn + visibleColumns, getTimeFrames());
     int cursorColumn = static_cast<int>(cursorPosition);
-    if (cursorColumn >= startColumn && cursorColumn < endColumn) {
-        // Calculate cursor X position on screen
-        float cursorX = ((cursorColumn - startColumn) / static_cast<float>(visibleColumns)) * width();
+    if (cursorPosition < 0 || visibleColumns <= 0 || cursorColumn < startColumn || cursorColumn >= endColumn) {
+        playheadItem->hide();
+        return;
+    }
 
-        // Draw the cursor as a red line
-        painter.setPen(QPen(Qt::red, 2));
-        painter.drawLine(QPointF(cursorX, 0), QPointF(cursorX, height() - 20));
+    // Calculate cursor X position on screen
+    float cursorX = ((cursorColumn - startColumn) / static_cast<float>(visibleColumns)) * width();
+    playheadItem->setPos(cursorX, 0);
+    playheadItem->show();
+}
+
+
+
+void SpectrogramView::updateOverlays() {
+    const int visibleColumns = static_cast<int>(width() / zoomLevel);
+    const int startColumn = currentOffset;
+    const qreal bottom = height() - 20;
+    playheadItem->setLine(0, 0, 0, bottom);
+
+    auto columnToX = [&](double seconds) {
+        double column = seconds / duration * getTimeFrames();
+        return (column - startColumn) / visibleColumns * width();
+    };
+
+    // Beat grid, bars brighter; left out when the beats would be closer than a few pixels
+    QPainterPath beats;
+    QPainterPath downbeats;
+    const BeatGrid* grid = audioPlayer ? &audioPlayer->getBeatGrid() : nullptr;
+    if (grid && grid->isValid() && duration > 0.0f && visibleColumns > 0 && getTimeFrames() > 0) {
+        const double startSeconds = static_cast<double>(startColumn) / getTimeFrames() * duration;
+        const double endSeconds = static_cast<double>(startColumn + visibleColumns) / getTimeFrames() * duration;
+        const double beatPixels = grid->samplesPerBeat() / grid->sampleRate() / (endSeconds - startSeconds) * width();
+        if (beatPixels >= 4.0) {
+            const int64_t firstBeat = grid->beatAtOrBefore(static_cast<int64_t>(startSeconds * grid->sampleRate()));
+            for (int64_t beat = firstBeat;; ++beat) {
+                double seconds = static_cast<double>(grid->beatSample(beat)) / grid->sampleRate();
+                if (seconds > endSeconds) {
+                    break;
+                }
+                if (seconds < 0.0) {
+                    continue;
+                }
+                QPainterPath& path = grid->isDownbeat(beat) ? downbeats : beats;
+                double x = columnToX(seconds);
+                path.moveTo(x, 0);
+                path.lineTo(x, bottom);
+            }
+        }
     }
+    beatItem->setPath(beats);
+    downbeatItem->setPath(downbeats);
+
+    // Loop region, shaded behind the cursor
+    if (audioPlayer && audioPlayer->hasLoopRegion() && duration > 0.0f && visibleColumns > 0) {
+        double loopStartX = columnToX(static_cast<double>(audioPlayer->getLoopStart()) / audioPlayer->getSampleRate());
+        double loopEndX = columnToX(static_cast<double>(audioPlayer->getLoopEnd()) / audioPlayer->getSampleRate());
+        loopItem->setRect(QRectF(QPointF(loopStartX, 0), QPointF(loopEndX, bottom)));
+        QPainterPath edges;
+        edges.moveTo(loopStartX, 0);
+        edges.lineTo(loopStartX, bottom);
+        edges.moveTo(loopEndX, 0);
+        edges.lineTo(loopEndX, bottom);
+        loopEdgesItem->setPath(edges);
+        loopItem->show();
+        loopEdgesItem->show();
+    } else {
+        loopItem->hide();
+        loopEdgesItem->hide();
+    }
+
+    updateCursorLayer();
 }
 
 
@@ -292,11 +426,11 @@ void SpectrogramView::resizeEvent(QResizeEvent* event) {
 }
 
 int SpectrogramView::getFrequencyBins() const {
-    return static_cast<int>(spectrogramData.size());
+    return spectrogram ? static_cast<int>(spectrogram->bins()) : 0;
 }
 
 int SpectrogramView::getTimeFrames() const {
-    return spectrogramData.empty() ? 0 : static_cast<int>(spectrogramData[0].size());
+    return spectrogram ? static_cast<int>(spectrogram->frames()) : 0;
 }
 
 const std::vector<std::shared_ptr<Waypoint>>& SpectrogramView::getWaypoints() const {
@@ -312,51 +446,6 @@ std::pair<int, int> SpectrogramView::getViewRange() const {
 }
 
 
-std::vector<std::vector<float>> SpectrogramView::downsampleSpectrogram(
-    const std::vector<std::vector<float>>& data,
-    int targetTimeFrames,
-    int targetFrequencyBins) {
-    
-    int originalTimeFrames = static_cast<int>(data[0].size());
-    int originalFrequencyBins = static_cast<int>(data.size());
-
-    // Compute downsampling factors
-    float timeStep = static_cast<float>(originalTimeFrames) / targetTimeFrames;
-    float frequencyStep = static_cast<float>(originalFrequencyBins) / targetFrequencyBins;
-
-    // Create a new downsampled spectrogram
-    std::vector<std::vector<float>> downsampled(targetFrequencyBins, std::vector<float>(targetTimeFrames, 0.0f));
-
-    for (int i = 0; i < targetFrequencyBins; ++i) {
-        int originalFreqIndexStart = static_cast<int>(i * frequencyStep);
-        int originalFreqIndexEnd = std::min(static_cast<int>((i + 1) * frequencyStep), originalFrequencyBins);
-
-        for (int j = 0; j < targetTimeFrames; ++j) {
-            int originalTimeIndexStart = static_cast<int>(j * timeStep);
-            int originalTimeIndexEnd = std::min(static_cast<int>((j + 1) * timeStep), originalTimeFrames);
-
-            // Average over the original data range
-            float sum = 0.0f;
-            int count = 0;
-
-            for (int fi = originalFreqIndexStart; fi < originalFreqIndexEnd; ++fi) {
-                for (int ti = originalTimeIndexStart; ti < originalTimeIndexEnd; ++ti) {
-                    sum += data[fi][ti];
-                    ++count;
-                }
-            }
-
-            float average = (count > 0) ? (sum / count) : 0.0f;
-
-            // Apply logarithmic scaling
-            downsampled[i][j] = (std::log10(std::max(average, 0.01f)) - std::log10(0.01f)) /
-                                (std::log10(10.0f) - std::log10(0.01f));
-        }
-    }
-
-    return downsampled;
-}
-
 void SpectrogramView::connectAudioPlayer(AudioPlayer* player) {
     if (player) {
         audioPlayer = player;
@@ -374,21 +463,32 @@ void SpectrogramView::connectAudioPlayer(AudioPlayer* player) {
 void SpectrogramView::updateCursor() {
     if (!scene || !audioPlayer || duration <= 0.0f) return;
 
-    // Get the current playback time from the audio player
-    float currentTime = audioPlayer->getCurrentTime();
+    // What the audience hears right now (audio clock, DAC side). The cursor and the waypoint
+    // trigger below both use this one value, so the lights change together with the sound.
+    double currentTime = audioPlayer->getCurrentTime();
 
     // Calculate the cursor position based on playback time
-    cursorPosition = (currentTime / duration) * spectrogramData[0].size();
+    cursorPosition = static_cast<float>((currentTime / duration) * getTimeFrames());
 
     // Ensure the cursor stays within bounds
-    cursorPosition = std::clamp(cursorPosition, 0.0f, static_cast<float>(spectrogramData[0].size() - 1));
+    cursorPosition = std::clamp(cursorPosition, 0.0f, static_cast<float>(getTimeFrames() - 1));
 
     // Check if the cursor is out of the visible range
     int visibleColumns = static_cast<int>(width() / zoomLevel);
     int startColumn = currentOffset;
-    int endColumn = std::min(startColumn + visibleColumns, static_cast<int>(spectrogramData[0].size()));
+    int endColumn = std::min(startColumn + visibleColumns, getTimeFrames());
 
-    if (cursorPosition >= endColumn) {
+    if (followPlayhead) {
+        // Keep the cursor centered; the renderer shifts the last frame and draws the few new columns
+        int centered = std::clamp(static_cast<int>(cursorPosition) - visibleColumns / 2, 0,
+                                  std::max(0, getTimeFrames() - visibleColumns));
+        if (centered != startColumn) {
+            currentOffset = centered;
+            updateView();
+        } else {
+            updateCursorLayer();
+        }
+    } else if (cursorPosition >= endColumn) {
         std::cout << "Cursor out of view on the right. Scrolling forward." << std::endl;
         scrollBy(endColumn - startColumn); // Scroll forward
         updateView(); // Update the full view
@@ -398,7 +498,26 @@ void SpectrogramView::updateCursor() {
         updateView(); // Update the full view
     } else {
         // Cursor is within the visible range; update only the cursor layer
+        auto tickStart = std::chrono::high_resolution_clock::now();
         updateCursorLayer();
+        double tickMicroseconds = std::chrono::duration<double, std::micro>(
+            std::chrono::high_resolution_clock::now() - tickStart).count();
+        cursorTickTotal += tickMicroseconds;
+        cursorTickMax = std::max(cursorTickMax, tickMicroseconds);
+        if (++cursorTicks == 1000) {
+            std::cout << "Cursor tick: avg " << cursorTickTotal / cursorTicks << " us, max "
+                      << cursorTickMax << " us over " << cursorTicks << " ticks" << std::endl;
+            cursorTicks = 0;
+            cursorTickTotal = 0.0;
+            cursorTickMax = 0.0;
+        }
+    }
+
+    // Playback wrapped to the loop start (the clock jumped with it): send that waypoint's state again
+    uint64_t loopWraps = audioPlayer->getLoopWrapCount();
+    if (loopWraps != seenLoopWraps) {
+        seenLoopWraps = loopWraps;
+        lastEmittedWaypoint = nullptr;
     }
 
     // Find the last waypoint before or at the cursor position
@@ -439,18 +558,16 @@ void SpectrogramView::mousePressEvent(QMouseEvent* event) {
             }
         }
 
-        // If no waypoint is clicked, handle cursor logic
-        int clickX = event->pos().x();
-        int visibleColumns = static_cast<int>(width() / zoomLevel);
-        int startColumn = currentOffset;
-
-        int clickedColumn = startColumn + static_cast<int>((clickX / static_cast<float>(width())) * visibleColumns);
-        clickedColumn = std::clamp(clickedColumn, 0, getTimeFrames() - 1);
-
-        float newPlaybackTime = (clickedColumn / static_cast<float>(spectrogramData[0].size())) * duration;
+        // If no waypoint is clicked, handle cursor logic: scrub from here until the button is released
+        int clickedColumn = columnAtX(event->pos().x());
+        float newPlaybackTime = (clickedColumn / static_cast<float>(getTimeFrames())) * duration;
 
         if (audioPlayer) {
-            audioPlayer->seek(newPlaybackTime);
+            audioPlayer->beginScrub(newPlaybackTime);
+            scrubbing = audioPlayer->isScrubbing();
+            if (!scrubbing) {
+                audioPlayer->seek(newPlaybackTime);
+            }
         }
 
         std::cout << "Mouse clicked at column: " << clickedColumn
@@ -467,8 +584,35 @@ void SpectrogramView::mousePressEvent(QMouseEvent* event) {
 
 
 
+void SpectrogramView::mouseMoveEvent(QMouseEvent* event) {
+    if (scrubbing && (event->buttons() & Qt::LeftButton)) {
+        // Only an atomic store on the player; the grains follow within one audio buffer
+        int column = columnAtX(event->pos().x());
+        audioPlayer->scrubTo((column / static_cast<float>(getTimeFrames())) * duration);
+        cursorPosition = static_cast<float>(column);
+        updateCursorLayer();
+        return;
+    }
+    QGraphicsView::mouseMoveEvent(event);
+}
+
+void SpectrogramView::mouseReleaseEvent(QMouseEvent* event) {
+    if (scrubbing && event->button() == Qt::LeftButton) {
+        scrubbing = false;
+        audioPlayer->endScrub();
+        updateCursor();
+    }
+    QGraphicsView::mouseReleaseEvent(event);
+}
+
+int SpectrogramView::columnAtX(int x) const {
+    int visibleColumns = static_cast<int>(width() / zoomLevel);
+    int column = currentOffset + static_cast<int>((x / static_cast<float>(width())) * visibleColumns);
+    return std::clamp(column, 0, std::max(0, getTimeFrames() - 1));
+}
+
 void SpectrogramView::updateCursorFromAudio(double currentTime) {
-    cursorPosition = (currentTime / duration) * spectrogramData[0].size();
+    cursorPosition = (currentTime / duration) * getTimeFrames();
     updateCursorLayer();
 }
 
@@ -485,8 +629,9 @@ void SpectrogramView::addWaypoint(const Waypoint& waypoint)
         return;
     }
 
-    // Create a shared_ptr for the new waypoint
+    // Create a shared_ptr for the new waypoint, on the beat grid when snapping
     auto waypointPtr = std::make_shared<Waypoint>(waypoint);
+    waypointPtr->timeInSeconds = snapTime(waypointPtr->timeInSeconds);
     waypoints.push_back(waypointPtr);
 
     // Sort waypoints by time
@@ -561,7 +706,7 @@ void SpectrogramView::updateWaypointPositions()
     }
 
     float visibleColumns = width() / zoomLevel;
-    float totalColumns = spectrogramData[0].size();
+    float totalColumns = getTimeFrames();
 
     for (int i = 0; i < static_cast<int>(waypoints.size()); ++i) {
         const auto& waypoint = waypoints[i];
@@ -596,6 +741,65 @@ void SpectrogramView::updateWaypointPositions()
 
 
 
+void SpectrogramView::updateRaster(const SpectrogramZoom& zoom, int rows)
+{
+    // Pick the pyramid level closest to the current zoom; its frames are 2^level base columns wide.
+    // There is no pyramid yet while a track is loading progressively.
+    size_t level = pyramid.levelForFramesPerPixel(zoom.visibleColumns / static_cast<float>(zoom.width));
+    std::shared_ptr<const SpectrogramBuffer> levelData = pyramid.empty() ? spectrogram : pyramid.sharedLevel(level);
+    if (raster && raster->zoom() == zoom && raster->rows() == rows && raster->source() == levelData.get() &&
+        raster->palette() == colormap.palette()) {
+        return;
+    }
+
+    // Tiles of other zooms stay valid, those of another image height do not
+    if (raster && raster->rows() != rows) {
+        renderer->tiles().clear();
+    }
+    raster = std::make_shared<const SpectrogramRaster>(std::move(levelData), static_cast<int>(level), zoom, rows,
+                                                       getFrequencyBins(), colormap);
+}
+
+void SpectrogramView::setColormap(SpectrogramColormap::Palette palette)
+{
+    if (palette == colormap.palette()) {
+        return;
+    }
+    colormap = SpectrogramColormap(palette);
+    renderer->tiles().clear();
+    if (spectrogram && !spectrogram->empty()) {
+        updateView();
+    }
+}
+
+float SpectrogramView::mapTimeToX(double seconds) const
+{
+    float visibleColumns = width() / zoomLevel;
+    float column = static_cast<float>(seconds / duration) * getTimeFrames();
+    return ((column - currentOffset) / visibleColumns) * width();
+}
+
+void SpectrogramView::setFollowPlayhead(bool enabled)
+{
+    followPlayhead = enabled;
+    updateCursor();
+}
+
+void SpectrogramView::setSnapToBeat(bool enabled, int subdivision)
+{
+    snapToBeat = enabled;
+    snapSubdivision = std::max(1, subdivision);
+}
+
+double SpectrogramView::snapTime(double seconds) const
+{
+    // The player's grid, so snapped waypoints land on the metronome's clicks to the sample
+    if (!snapToBeat || !audioPlayer) {
+        return seconds;
+    }
+    return std::max(0.0, audioPlayer->getBeatGrid().quantizeTime(seconds, snapSubdivision));
+}
+
 float SpectrogramView::mapXToTime(float x) const
 {
     qWarning() << "=== mapXToTime Debug ===";
@@ -603,9 +807,9 @@ float SpectrogramView::mapXToTime(float x) const
     qWarning() << "width() =" << width();
     qWarning() << "zoomLevel =" << zoomLevel;
     qWarning() << "currentOffset =" << currentOffset;
-    // Check if spectrogramData is empty before accessing spectrogramData[0]
-    size_t timeFrames = (!spectrogramData.empty() ? spectrogramData[0].size() : 1);
-    qWarning() << "spectrogramData[0].size() =" << timeFrames;
+    // Guard against an empty spectrogram before dividing by the frame count
+    size_t timeFrames = (getTimeFrames() > 0 ? getTimeFrames() : 1);
+    qWarning() << "spectrogram->frames() =" << timeFrames;
     qWarning() << "duration =" << duration;
 
     float visibleColumns = width() / zoomLevel;
@@ -712,6 +916,12 @@ QVariant SelectableWaypoint::itemChange(GraphicsItemChange change, const QVarian
         if (newPos.x() < 0) {
             newPos.setX(0);
         }
+
+        // While dragging, jump between beats when snapping is on
+        auto* view = scene() && !scene()->views().isEmpty() ? dynamic_cast<SpectrogramView*>(scene()->views().first()) : nullptr;
+        if (view && view->isSnappingToBeat() && scene()->mouseGrabberItem() == this) {
+            newPos.setX(std::max(0.0f, view->mapTimeToX(view->snapTime(view->mapXToTime(newPos.x())))));
+        }
         return QGraphicsLineItem::itemChange(change, newPos);
     }
     else if (change == QGraphicsItem::ItemPositionHasChanged) {
@@ -741,7 +951,7 @@ void SelectableWaypoint::updateWaypointInList(const QPointF& newPos) {
             return;
         }
 
-        float newTime = spectrogramView->mapXToTime(newPos.x());
+        double newTime = spectrogramView->snapTime(spectrogramView->mapXToTime(newPos.x()));
 
         // Update only this waypoint's timeInSeconds
         if (waypointPtr) {
@@ -0,0 +1,80 @@
+#include "include/ui/WaveformLane.h"
+#include <QPainter>
+#include <QPaintEvent>
+#include <QResizeEvent>
+#include <algorithm>
+#include <cmath>
+
+WaveformLane::WaveformLane(QWidget* parent) : QWidget(parent) {
+    setMinimumHeight(60);
+    setMaximumHeight(120);
+    setAttribute(Qt::WA_OpaquePaintEvent);
+}
+
+void WaveformLane::setOverview(std::shared_ptr<const WaveformOverview> newOverview) {
+    overview = std::move(newOverview);
+    if (overview && endSeconds <= startSeconds) {
+        endSeconds = overview->duration(); // Whole track until the spectrogram reports its range
+    }
+    refreshColumns();
+}
+
+void WaveformLane::setVisibleRange(double start, double end) {
+    if (start == startSeconds && end == endSeconds) {
+        return;
+    }
+    startSeconds = start;
+    endSeconds = end;
+    refreshColumns();
+}
+
+void WaveformLane::setCursorTime(double seconds) {
+    if (seconds == cursorSeconds) {
+        return;
+    }
+    cursorSeconds = seconds;
+    update();
+}
+
+void WaveformLane::resizeEvent(QResizeEvent* event) {
+    QWidget::resizeEvent(event);
+    refreshColumns();
+}
+
+void WaveformLane::refreshColumns() {
+    if (overview && width() > 0 && endSeconds > startSeconds) {
+        columns = overview->queryTime(startSeconds, endSeconds, static_cast<size_t>(width()));
+    } else {
+        columns.clear();
+    }
+    update();
+}
+
+void WaveformLane::paintEvent(QPaintEvent* event) {
+    QPainter painter(this);
+    painter.fillRect(event->rect(), Qt::black);
+
+    const float center = height() / 2.0f;
+    const float scale = height() / 2.0f - 1.0f;
+    const int firstX = std::max(0, event->rect().left());
+    const int lastX = std::min(static_cast<int>(columns.size()), event->rect().right() + 1);
+
+    // Peaks first, the RMS band drawn over them
+    painter.setPen(QColor(70, 110, 200));
+    for (int x = firstX; x < lastX; ++x) {
+        const WaveformColumn& column = columns[x];
+        painter.drawLine(x, static_cast<int>(center - column.max * scale), x, static_cast<int>(center - column.min * scale));
+    }
+    painter.setPen(QColor(150, 190, 255));
+    for (int x = firstX; x < lastX; ++x) {
+        float rms = std::min(columns[x].rms, 1.0f) * scale;
+        painter.drawLine(x, static_cast<int>(center - rms), x, static_cast<int>(center + rms));
+    }
+
+    // Playhead, where the spectrogram draws its cursor
+    if (endSeconds > startSeconds && cursorSeconds >= startSeconds && cursorSeconds <= endSeconds) {
+        int x = static_cast<int>((cursorSeconds - startSeconds) / (endSeconds - startSeconds) * width());
+        painter.setPen(QPen(Qt::red, 2));
+        painter.drawLine(x, 0, x, height());
+    }
+}